@@ -0,0 +1,315 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/key.h"
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace io::skizzay::identigen {
+   // Hashed timer wheel for an event loop: timers are intrusive, so scheduling is a push onto a slot's list and never
+   // allocates, and advancing the wheel only visits the slots it passes. Timers due more than one revolution ahead stay
+   // in their slot until their deadline comes round. A timer fires on the first advance at or after its deadline, so
+   // it is never late by more than the time between advances. Not thread-safe; the loop that advances the wheel owns
+   // it.
+   template<typename Clock = std::chrono::steady_clock>
+   class timer_wheel final {
+   public:
+      using time_point = typename Clock::time_point;
+      using duration = typename Clock::duration;
+
+      // A scheduled timer must be cancelled before it is destroyed
+      struct timer {
+         timer *next = nullptr;
+         // The pointer to this timer in the list holding it, while it is scheduled
+         timer **link = nullptr;
+         time_point deadline;
+         void (*fire)(timer &) = nullptr;
+
+         [[nodiscard]]
+         bool scheduled() const noexcept {
+            return nullptr != link;
+         }
+      };
+
+      explicit timer_wheel(duration const resolution, std::size_t const num_slots = 256,
+                           time_point const now = Clock::now())
+         : resolution_{validate_resolution(resolution)},
+           origin_{now},
+           now_{now},
+           slots_(validate_num_slots(num_slots), nullptr) {
+      }
+
+      timer_wheel(timer_wheel const &) = delete;
+
+      timer_wheel &operator=(timer_wheel const &) = delete;
+
+      [[nodiscard]]
+      duration resolution() const noexcept {
+         return resolution_;
+      }
+
+      // Time the wheel was last advanced to
+      [[nodiscard]]
+      time_point now() const noexcept {
+         return now_;
+      }
+
+      [[nodiscard]]
+      bool empty() const noexcept {
+         return 0 == size_;
+      }
+
+      // Schedules t to fire on the first advance at or after deadline, in place of any time it was scheduled for.
+      // Deadlines already passed fire on the next advance.
+      void schedule(timer &t, time_point const deadline) noexcept {
+         cancel(t);
+         t.deadline = deadline;
+         push(slots_[std::max(tick_of(deadline), current_) % slots_.size()], t);
+         ++size_;
+      }
+
+      void schedule_after(timer &t, duration const delay) noexcept {
+         schedule(t, now_ + delay);
+      }
+
+      // Stops t from firing, if it is scheduled
+      void cancel(timer &t) noexcept {
+         if (t.scheduled()) {
+            unlink(t);
+            --size_;
+         }
+      }
+
+      // Fires every timer due by now and returns how many fired. The due timers are taken off the wheel before any
+      // fires, so fire may reschedule its own timer and cancel or destroy any other.
+      std::size_t advance(time_point const now) {
+         if (now <= now_) {
+            return 0;
+         }
+         now_ = now;
+         // The current tick is visited again, as it may hold timers that were not due when it was last visited. Ticks
+         // are visited latest first, so that pushing onto the due list leaves the earliest at its head.
+         auto const target = tick_of(now);
+         auto const last = std::min(target, current_ + slots_.size() - 1);
+         for (auto tick = last + 1; current_ < tick--;) {
+            for (auto *t = slots_[tick % slots_.size()]; nullptr != t;) {
+               auto *const next = t->next;
+               if (t->deadline <= now) {
+                  unlink(*t);
+                  push(due_, *t);
+               }
+               t = next;
+            }
+         }
+         current_ = target;
+         std::size_t fired = 0;
+         while (nullptr != due_) {
+            auto &t = *due_;
+            unlink(t);
+            --size_;
+            ++fired;
+            t.fire(t);
+         }
+         return fired;
+      }
+
+   private:
+      static duration validate_resolution(duration const resolution) {
+         if (resolution <= duration::zero()) {
+            throw std::invalid_argument{"Cannot create timer wheel, resolution must be positive"};
+         }
+         return resolution;
+      }
+
+      static std::size_t validate_num_slots(std::size_t const num_slots) {
+         if (0 == num_slots) {
+            throw std::invalid_argument{"Cannot create timer wheel, number of slots must be positive"};
+         }
+         return num_slots;
+      }
+
+      // Tick holding t
+      [[nodiscard]]
+      std::uint64_t tick_of(time_point const t) const noexcept {
+         return t <= origin_ ? 0 : static_cast<std::uint64_t>((t - origin_) / resolution_);
+      }
+
+      static void push(timer *&head, timer &t) noexcept {
+         t.next = head;
+         if (nullptr != head) {
+            head->link = &t.next;
+         }
+         head = &t;
+         t.link = &head;
+      }
+
+      static void unlink(timer &t) noexcept {
+         *t.link = t.next;
+         if (nullptr != t.next) {
+            t.next->link = t.link;
+         }
+         t.next = nullptr;
+         t.link = nullptr;
+      }
+
+      duration const resolution_;
+      time_point const origin_;
+      time_point now_;
+      std::uint64_t current_ = 0;
+      std::size_t size_ = 0;
+      std::vector<timer *> slots_;
+      timer *due_ = nullptr;
+   };
+
+   // Coroutine front end for a generator: co_await next(k) and co_await generate_n(ids, k) complete immediately while
+   // the generator has sequence numbers left, and otherwise park the coroutine on a timer wheel for one resolution
+   // before trying again, rather than spinning. Give the wheel the resolution of the generator's timestamp provider.
+   // Coroutines are resumed from timer_wheel::advance, on the event loop's thread.
+   template<typename Generator, typename Clock = std::chrono::steady_clock>
+   class async_generator final {
+   public:
+      using id_type = typename Generator::id_type;
+      using wheel_type = timer_wheel<Clock>;
+
+      async_generator(Generator &generator, wheel_type &wheel) noexcept
+         : generator_{generator},
+           wheel_{wheel} {
+      }
+
+      template<key K>
+      [[nodiscard]]
+      auto next(K k) noexcept {
+         return next_awaitable<K>{*this, std::move(k)};
+      }
+
+      // Completes once every ID in ids has been filled in
+      template<key K>
+      [[nodiscard]]
+      auto generate_n(std::span<id_type> const ids, K k) noexcept {
+         return generate_n_awaitable<K>{*this, ids, std::move(k)};
+      }
+
+   private:
+      // Awaitable retrying Derived::attempt each time the wheel fires until it reports completion
+      template<typename Derived>
+      class parked_awaitable : public wheel_type::timer {
+      public:
+         explicit parked_awaitable(async_generator &owner) noexcept
+            : owner_{owner} {
+         }
+
+         parked_awaitable(parked_awaitable const &) = delete;
+
+         parked_awaitable &operator=(parked_awaitable const &) = delete;
+
+         // A coroutine destroyed while parked takes its timer off the wheel
+         ~parked_awaitable() {
+            owner_.wheel_.cancel(*this);
+         }
+
+         bool await_ready() {
+            return self().attempt();
+         }
+
+         void await_suspend(std::coroutine_handle<> const handle) noexcept {
+            handle_ = handle;
+            this->fire = &retry;
+            owner_.wheel_.schedule_after(*this, owner_.wheel_.resolution());
+         }
+
+      protected:
+         void rethrow_failure() const {
+            if (failure_) {
+               std::rethrow_exception(failure_);
+            }
+         }
+
+         async_generator &owner_;
+
+      private:
+         Derived &self() noexcept {
+            return static_cast<Derived &>(*this);
+         }
+
+         static void retry(typename wheel_type::timer &t) {
+            auto &awaitable = static_cast<parked_awaitable &>(t);
+            try {
+               if (!awaitable.self().attempt()) {
+                  awaitable.owner_.wheel_.schedule_after(awaitable, awaitable.owner_.wheel_.resolution());
+                  return;
+               }
+            }
+            catch (...) {
+               awaitable.failure_ = std::current_exception();
+            }
+            awaitable.handle_.resume();
+         }
+
+         std::coroutine_handle<> handle_;
+         std::exception_ptr failure_;
+      };
+
+      template<typename K>
+      class next_awaitable final : public parked_awaitable<next_awaitable<K> > {
+      public:
+         next_awaitable(async_generator &owner, K k) noexcept
+            : parked_awaitable<next_awaitable>{owner},
+              key_{std::move(k)} {
+         }
+
+         bool attempt() {
+            id_ = this->owner_.generator_.try_next(key_);
+            return id_.has_value();
+         }
+
+         id_type await_resume() const {
+            this->rethrow_failure();
+            return *id_;
+         }
+
+      private:
+         K key_;
+         std::optional<id_type> id_;
+      };
+
+      template<typename K>
+      class generate_n_awaitable final : public parked_awaitable<generate_n_awaitable<K> > {
+      public:
+         generate_n_awaitable(async_generator &owner, std::span<id_type> const ids, K k) noexcept
+            : parked_awaitable<generate_n_awaitable>{owner},
+              ids_{ids},
+              key_{std::move(k)} {
+         }
+
+         bool attempt() {
+            filled_ += this->owner_.generator_.try_generate_n(ids_.subspan(filled_), key_);
+            return ids_.size() == filled_;
+         }
+
+         void await_resume() const {
+            this->rethrow_failure();
+         }
+
+      private:
+         std::span<id_type> ids_;
+         K key_;
+         std::size_t filled_ = 0;
+      };
+
+      Generator &generator_;
+      wheel_type &wheel_;
+   };
+} // io::skizzay::identigen
@@ -4,32 +4,38 @@
 
 #pragma once
 
+#include "io/skizzay/identigen/byte_order.h"
+#include "io/skizzay/identigen/record.h"
+#include "io/skizzay/identigen/varint.h"
+
 #include <limits>
 #include <span>
 #include <stdexcept>
 #include <algorithm>
 #include <bit>
+#include <concepts>
+#include <expected>
+#include <functional>
+#include <type_traits>
 #include <utility>
 #include <array>
-#if __has_include(<ieee754.h>)
-#include <ieee754.h>
-#endif
 
 namespace io::skizzay::identigen {
    struct buffer_overflow : std::runtime_error {
       using std::runtime_error::runtime_error;
    };
 
-   constexpr inline std::endian float_word_order = []() -> std::endian {
-      if constexpr (std::endian::big == std::endian::native) {
-         return std::endian::big;
-      }
-      else {
-         // I've spent too much time on this, and I'm not sure if it's even possible to detect the float word order
-         // without using preprocessor macros.
-         return __FLOAT_WORD_ORDER == __ORDER_BIG_ENDIAN__ ? std::endian::big : std::endian::little;
-      }
-   }();
+   // Why a try_ operation on a buffer failed. The throwing operations report the same failures as buffer_overflow and
+   // std::out_of_range respectively.
+   enum class buffer_error {
+      // Fewer bytes remain than the value needs
+      not_enough_space,
+      // The value read does not fit the requested type or the destination
+      out_of_range
+   };
+
+   template<typename T>
+   concept buffer_scalar = std::integral<T> || std::same_as<T, float> || std::same_as<T, double>;
 
    template<std::endian E>
    struct read_buffer final {
@@ -43,69 +49,19 @@ namespace io::skizzay::identigen {
 
          template<std::integral I>
          constexpr explicit operator I() {
-            reader_.validate_read_size(sizeof(I));
-            std::remove_cv_t<I> x = {};
-            reader_.template decode<I>(x);
-            reader_.advance(sizeof(I));
-            return x;
+            return value_or_throw(reader_.template try_get<std::remove_cv_t<I> >());
          }
 
          constexpr explicit operator float() const {
-            reader_.validate_read_size(sizeof(float));
-            std::uint32_t x = {};
-            reader_.decode(x);
-            reader_.advance(sizeof(float));
-            return std::bit_cast<float>(x);
+            return value_or_throw(reader_.template try_get<float>());
          }
 
          constexpr explicit operator double() const {
-            reader_.validate_read_size(sizeof(double));
-            std::array<std::uint32_t, 2> parts = {};
-            if constexpr (std::endian::big == std::endian::native || std::endian::big == float_word_order) {
-               if constexpr (std::endian::big == E) {
-                  reader_.decode(parts[0]);
-                  reader_.advance(sizeof(parts[0]));
-                  reader_.decode(parts[1]);
-                  reader_.advance(sizeof(parts[1]));
-               }
-               else {
-                  reader_.decode(parts[1]);
-                  reader_.advance(sizeof(parts[1]));
-                  reader_.decode(parts[0]);
-                  reader_.advance(sizeof(parts[0]));
-               }
-            }
-            else {
-               if constexpr (std::endian::big == E) {
-                  reader_.decode(parts[1]);
-                  reader_.advance(sizeof(parts[1]));
-                  reader_.decode(parts[0]);
-                  reader_.advance(sizeof(parts[0]));
-               }
-               else {
-                  reader_.decode(parts[0]);
-                  reader_.advance(sizeof(parts[0]));
-                  reader_.decode(parts[1]);
-                  reader_.advance(sizeof(parts[1]));
-               }
-            }
-            reader_.advance(sizeof(double));
-            return std::bit_cast<double>(parts);
+            return value_or_throw(reader_.template try_get<double>());
          }
 
          constexpr explicit operator std::span<std::byte const>() {
-            auto const recovery_position = reader_.position();
-            try {
-               auto const n = static_cast<size_type>(*this);
-               reader_.validate_read_size(n);
-               auto const result = reader_.buffer_.subspan(reader_.position_, n);
-               reader_.advance(n);
-               return result;
-            }
-            catch (...) {
-               reader_.position_ = recovery_position;
-               throw;
-            }
+            return value_or_throw(reader_.template try_get<std::span<std::byte const> >());
          }
 
       private:
@@ -116,6 +72,26 @@ namespace io::skizzay::identigen {
          read_buffer &reader_;
       };
 
+      // Reads scalars from bytes that require() has already bounds checked, so that no read in between branches
+      class unchecked_reader final {
+      public:
+         friend struct read_buffer;
+
+         template<buffer_scalar T>
+         T get() noexcept {
+            auto const x = load<T>(cursor_);
+            cursor_ += sizeof(T);
+            return x;
+         }
+
+      private:
+         explicit unchecked_reader(std::byte const *const cursor) noexcept
+            : cursor_{cursor} {
+         }
+
+         std::byte const *cursor_;
+      };
+
       explicit read_buffer(underlying_type const buffer, size_type const offset = {}) noexcept
          : buffer_{buffer},
            position_{offset} {
@@ -136,10 +112,185 @@ namespace io::skizzay::identigen {
          return position_;
       }
 
+      size_type position(size_type const n) {
+         if (capacity() < n) {
+            throw std::out_of_range{"Cannot set position, position is greater than capacity"};
+         }
+         return std::exchange(position_, n);
+      }
+
+      // The bytes that have not been read yet
+      [[nodiscard]]
+      underlying_type available_bytes() const noexcept {
+         return buffer_.subspan(position_);
+      }
+
       decoder get() noexcept {
          return decoder{*this};
       }
 
+      // As get(), but reports failure instead of throwing; the position only moves on success
+      template<typename T>
+         requires buffer_scalar<T> || std::same_as<T, std::span<std::byte const> >
+      std::expected<T, buffer_error> try_get() noexcept {
+         if constexpr (buffer_scalar<T>) {
+            if (remaining() < sizeof(T)) {
+               return std::unexpected{buffer_error::not_enough_space};
+            }
+            auto const x = load<T>(buffer_.data() + position_);
+            advance(sizeof(T));
+            return x;
+         }
+         else {
+            if (remaining() < sizeof(size_type)) {
+               return std::unexpected{buffer_error::not_enough_space};
+            }
+            auto const n = load<size_type>(buffer_.data() + position_);
+            if (remaining() - sizeof(size_type) < n) {
+               return std::unexpected{buffer_error::not_enough_space};
+            }
+            auto const result = buffer_.subspan(position_ + sizeof(size_type), n);
+            advance(sizeof(size_type) + n);
+            return result;
+         }
+      }
+
+      // Reads a range written by write_buffer::put into the front of values, checking bounds once for the whole range.
+      // Returns the number of values read.
+      template<typename T, std::size_t N>
+         requires byte_order_utilities::is_bulk_codable<T>
+      size_type get(std::span<T, N> const values) {
+         return value_or_throw(try_get(values));
+      }
+
+      template<typename T, std::size_t N>
+         requires byte_order_utilities::is_bulk_codable<T>
+      std::expected<size_type, buffer_error> try_get(std::span<T, N> const values) noexcept {
+         if (remaining() < sizeof(size_type)) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         auto const n = load<size_type>(buffer_.data() + position_);
+         if (values.size() < n) {
+            return std::unexpected{buffer_error::out_of_range};
+         }
+         if ((remaining() - sizeof(size_type)) / sizeof(T) < n) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         byte_order_utilities::decode<E>(buffer_.data() + position_ + sizeof(size_type), std::span<T>{values}.first(n));
+         advance(sizeof(size_type) + n * sizeof(T));
+         return n;
+      }
+
+      template<std::integral T>
+      T get_varint() {
+         return value_or_throw(try_get_varint<T>());
+      }
+
+      template<std::integral T>
+      std::expected<T, buffer_error> try_get_varint() noexcept {
+         T x = {};
+         auto const consumed = varint_utilities::decode(buffer_.data() + position_, remaining(), x);
+         if (0 == consumed) {
+            return std::unexpected{varint_error<T>(position_)};
+         }
+         advance(consumed);
+         return x;
+      }
+
+      // Reads a range written by write_buffer::put_varint into the front of values. Returns the number of values read.
+      template<std::integral T, std::size_t N>
+      size_type get_varint(std::span<T, N> const values) {
+         return value_or_throw(try_get_varint(values));
+      }
+
+      template<std::integral T, std::size_t N>
+      std::expected<size_type, buffer_error> try_get_varint(std::span<T, N> const values) noexcept {
+         size_type n = 0;
+         auto const prefix = varint_utilities::decode(buffer_.data() + position_, remaining(), n);
+         if (0 == prefix) {
+            return std::unexpected{varint_error<size_type>(position_)};
+         }
+         if (values.size() < n) {
+            return std::unexpected{buffer_error::out_of_range};
+         }
+         auto const start = position_ + prefix;
+         auto const [decoded, consumed] = varint_utilities::decode_n(buffer_.data() + start, capacity() - start,
+                                                                     std::span<T>{values}.first(n));
+         if (decoded < n) {
+            return std::unexpected{varint_error<T>(start + consumed)};
+         }
+         advance(prefix + consumed);
+         return n;
+      }
+
+      // Reads a record written by write_buffer::put_record, checking bounds once for the whole record
+      template<fixed_size_record T>
+         requires std::default_initializable<T>
+      T get_record() {
+         return value_or_throw(try_get_record<T>());
+      }
+
+      template<fixed_size_record T>
+         requires std::default_initializable<T>
+      std::expected<T, buffer_error> try_get_record() noexcept(std::is_nothrow_default_constructible_v<T>) {
+         return try_require(record_utilities::size<T>(), [](unchecked_reader &reader) {
+            T x{};
+            record_utilities::for_each_field(x, [&reader]<typename F>(F &field) {
+               field = static_cast<F>(reader.template get<record_utilities::encoded_type<F> >());
+            });
+            return x;
+         });
+      }
+
+      // Views the next n values of T in place instead of decoding them, checking once that they are all there. T is
+      // typically a packed struct of big_endian/little_endian fields matching what write_buffer::put_record wrote, so
+      // only the fields that are read get byte swapped. The view refers to the underlying bytes.
+      template<byte_overlay T>
+      std::span<T const> overlay(size_type const n) {
+         return value_or_throw(try_overlay<T>(n));
+      }
+
+      template<byte_overlay T>
+      std::expected<std::span<T const>, buffer_error> try_overlay(size_type const n) noexcept {
+         if (remaining() / sizeof(T) < n) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         auto const values = std::span{reinterpret_cast<T const *>(buffer_.data() + position_), n};
+         advance(n * sizeof(T));
+         return values;
+      }
+
+      // Checks once that n bytes remain, then hands read an unchecked_reader over them and moves past what it read,
+      // which must be no more than n bytes. Returns what read returns.
+      template<std::invocable<unchecked_reader &> F>
+      std::invoke_result_t<F, unchecked_reader &> require(size_type const n, F &&read) {
+         if constexpr (std::is_void_v<std::invoke_result_t<F, unchecked_reader &> >) {
+            value_or_throw(try_require(n, std::forward<F>(read)));
+         }
+         else {
+            return value_or_throw(try_require(n, std::forward<F>(read)));
+         }
+      }
+
+      template<std::invocable<unchecked_reader &> F>
+      std::expected<std::invoke_result_t<F, unchecked_reader &>, buffer_error> try_require(size_type const n, F &&read) {
+         if (remaining() < n) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         auto const start = buffer_.data() + position_;
+         unchecked_reader reader{start};
+         if constexpr (std::is_void_v<std::invoke_result_t<F, unchecked_reader &> >) {
+            std::invoke(std::forward<F>(read), reader);
+            advance(static_cast<size_type>(reader.cursor_ - start));
+            return {};
+         }
+         else {
+            auto result = std::invoke(std::forward<F>(read), reader);
+            advance(static_cast<size_type>(reader.cursor_ - start));
+            return result;
+         }
+      }
+
       [[nodiscard]]
       read_buffer subreader(std::size_t const start, std::size_t const length) const {
          validate_subbuffer_size(start, length);
@@ -157,12 +308,38 @@ namespace io::skizzay::identigen {
       }
 
    private:
-      void validate_read_size(size_type const size) const {
-         if (remaining() < size) {
-            throw buffer_overflow{"Cannot read value from buffer, not enough space remaining"};
+      template<typename T>
+      static T value_or_throw(std::expected<T, buffer_error> &&result) {
+         if (!result) {
+            throw_error(result.error());
+         }
+         if constexpr (!std::is_void_v<T>) {
+            return *std::move(result);
          }
       }
 
+      [[noreturn]] static void throw_error(buffer_error const error) {
+         if (buffer_error::out_of_range == error) {
+            throw std::out_of_range{"Cannot read value from buffer, value does not fit the destination"};
+         }
+         throw buffer_overflow{"Cannot read value from buffer, not enough space remaining"};
+      }
+
+      // Tells a varint cut short by the end of the buffer from one that is too long for T
+      template<std::integral T>
+      buffer_error varint_error(size_type const start) const noexcept {
+         auto const limit = std::min(capacity(), start + varint_utilities::max_size<T>);
+         for (auto i = start; i < limit; ++i) {
+            if (0 == (static_cast<std::uint8_t>(buffer_[i]) & 0x80)) {
+               return buffer_error::out_of_range;
+            }
+         }
+         if (limit == start + varint_utilities::max_size<T>) {
+            return buffer_error::out_of_range;
+         }
+         return buffer_error::not_enough_space;
+      }
+
       void validate_subbuffer_size(size_type const start, size_type const length) const {
          if (capacity() < start + length) {
             throw buffer_overflow{"Cannot create subreader, not enough space remaining"};
@@ -176,8 +353,27 @@ namespace io::skizzay::identigen {
          position_ += n;
       }
 
+      template<buffer_scalar T>
+      static T load(std::byte const *const in) noexcept {
+         if constexpr (std::integral<T>) {
+            T x = {};
+            decode(x, in);
+            return x;
+         }
+         else if constexpr (std::same_as<T, float>) {
+            return std::bit_cast<float>(load<std::uint32_t>(in));
+         }
+         else {
+            std::array<std::uint32_t, 2> parts = {};
+            constexpr bool big_words_first = std::endian::big == std::endian::native || std::endian::big == float_word_order;
+            parts[big_words_first == (std::endian::big == E) ? 0 : 1] = load<std::uint32_t>(in);
+            parts[big_words_first == (std::endian::big == E) ? 1 : 0] = load<std::uint32_t>(in + sizeof(std::uint32_t));
+            return std::bit_cast<double>(parts);
+         }
+      }
+
       template<std::integral I>
-      void decode(I &x);
+      static void decode(I &x, std::byte const *in) noexcept;
 
       underlying_type buffer_;
       size_type position_;
@@ -185,29 +381,29 @@ namespace io::skizzay::identigen {
 
    template<>
    template<std::integral I>
-   void read_buffer<std::endian::little>::decode(I &x) {
+   void read_buffer<std::endian::little>::decode(I &x, std::byte const *const in) noexcept {
       if constexpr (8 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position() + 7]) << 56;
-         x |= static_cast<I>(buffer_[position() + 6]) << 48;
-         x |= static_cast<I>(buffer_[position() + 5]) << 40;
-         x |= static_cast<I>(buffer_[position() + 4]) << 32;
-         x |= static_cast<I>(buffer_[position() + 3]) << 24;
-         x |= static_cast<I>(buffer_[position() + 2]) << 16;
-         x |= static_cast<I>(buffer_[position() + 1]) << 8;
-         x |= static_cast<I>(buffer_[position()]);
+         x = static_cast<I>(in[7]) << 56;
+         x |= static_cast<I>(in[6]) << 48;
+         x |= static_cast<I>(in[5]) << 40;
+         x |= static_cast<I>(in[4]) << 32;
+         x |= static_cast<I>(in[3]) << 24;
+         x |= static_cast<I>(in[2]) << 16;
+         x |= static_cast<I>(in[1]) << 8;
+         x |= static_cast<I>(in[0]);
       }
       else if constexpr (4 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position() + 3]) << 24;
-         x |= static_cast<I>(buffer_[position() + 2]) << 16;
-         x |= static_cast<I>(buffer_[position() + 1]) << 8;
-         x |= static_cast<I>(buffer_[position()]);
+         x = static_cast<I>(in[3]) << 24;
+         x |= static_cast<I>(in[2]) << 16;
+         x |= static_cast<I>(in[1]) << 8;
+         x |= static_cast<I>(in[0]);
       }
       else if constexpr (2 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position() + 1]) << 8;
-         x |= static_cast<I>(buffer_[position()]);
+         x = static_cast<I>(in[1]) << 8;
+         x |= static_cast<I>(in[0]);
       }
       else if constexpr (1 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position()]);
+         x = static_cast<I>(in[0]);
       }
       else {
          static_assert(8 == sizeof(I), "Invalid integral size");
@@ -217,29 +413,29 @@ namespace io::skizzay::identigen {
 
    template<>
    template<std::integral I>
-   void read_buffer<std::endian::big>::decode(I &x) {
+   void read_buffer<std::endian::big>::decode(I &x, std::byte const *const in) noexcept {
       if constexpr (1 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position()]);
+         x = static_cast<I>(in[0]);
       }
       else if constexpr (2 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position()]) << 8;
-         x |= static_cast<I>(buffer_[position() + 1]);
+         x = static_cast<I>(in[0]) << 8;
+         x |= static_cast<I>(in[1]);
       }
       else if constexpr (4 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position()]) << 24;
-         x |= static_cast<I>(buffer_[position() + 1]) << 16;
-         x |= static_cast<I>(buffer_[position() + 2]) << 8;
-         x |= static_cast<I>(buffer_[position() + 3]);
+         x = static_cast<I>(in[0]) << 24;
+         x |= static_cast<I>(in[1]) << 16;
+         x |= static_cast<I>(in[2]) << 8;
+         x |= static_cast<I>(in[3]);
       }
       else if constexpr (8 == sizeof(I)) {
-         x = static_cast<I>(buffer_[position()]) << 56;
-         x |= static_cast<I>(buffer_[position() + 1]) << 48;
-         x |= static_cast<I>(buffer_[position() + 2]) << 40;
-         x |= static_cast<I>(buffer_[position() + 3]) << 32;
-         x |= static_cast<I>(buffer_[position() + 4]) << 24;
-         x |= static_cast<I>(buffer_[position() + 5]) << 16;
-         x |= static_cast<I>(buffer_[position() + 6]) << 8;
-         x |= static_cast<I>(buffer_[position() + 7]);
+         x = static_cast<I>(in[0]) << 56;
+         x |= static_cast<I>(in[1]) << 48;
+         x |= static_cast<I>(in[2]) << 40;
+         x |= static_cast<I>(in[3]) << 32;
+         x |= static_cast<I>(in[4]) << 24;
+         x |= static_cast<I>(in[5]) << 16;
+         x |= static_cast<I>(in[6]) << 8;
+         x |= static_cast<I>(in[7]);
       }
       else {
          static_assert(8 == sizeof(I), "Invalid integral size");
@@ -254,6 +450,8 @@ namespace io::skizzay::identigen {
       using element_type = underlying_type::element_type;
       using size_type = std::ranges::range_size_t<underlying_type>;
 
+      class unchecked_writer;
+
       explicit write_buffer(underlying_type const buffer, size_type const offset = {}) noexcept
          : buffer_{buffer},
            position_{offset} {
@@ -281,49 +479,19 @@ namespace io::skizzay::identigen {
          return std::exchange(position_, n);
       }
 
-      write_buffer &put(std::integral auto const x) {
-         validate_put_size(sizeof(x));
-         encode(x);
-         position_ += sizeof(x);
+      write_buffer &put(buffer_scalar auto const x) {
+         check(try_put(x));
          return *this;
       }
 
-      write_buffer &put(float const x) {
-         return put(std::bit_cast<std::uint32_t>(x));
-      }
-
-      write_buffer &put(double const x) {
-         validate_put_size(sizeof(x));
-         auto const parts = std::bit_cast<std::array<std::uint32_t, 2> >(x);
-         if constexpr (std::endian::big == std::endian::native || std::endian::big == float_word_order) {
-            if constexpr (std::endian::big == E) {
-               encode(parts[0]);
-               advance(sizeof(parts[0]));
-               encode(parts[1]);
-               advance(sizeof(parts[1]));
-            }
-            else {
-               encode(parts[1]);
-               advance(sizeof(parts[1]));
-               encode(parts[0]);
-               advance(sizeof(parts[0]));
-            }
+      // As put(), but reports failure instead of throwing; nothing is written unless the whole value fits
+      std::expected<void, buffer_error> try_put(buffer_scalar auto const x) noexcept {
+         if (remaining() < sizeof(x)) {
+            return std::unexpected{buffer_error::not_enough_space};
          }
-         else {
-            if constexpr (std::endian::big == E) {
-               encode(parts[1]);
-               advance(sizeof(parts[1]));
-               encode(parts[0]);
-               advance(sizeof(parts[0]));
-            }
-            else {
-               encode(parts[0]);
-               advance(sizeof(parts[0]));
-               encode(parts[1]);
-               advance(sizeof(parts[1]));
-            }
-         }
-         return *this;
+         store(x, buffer_.data() + position_);
+         advance(sizeof(x));
+         return {};
       }
 
       // template<std::size_t N>
@@ -344,24 +512,112 @@ namespace io::skizzay::identigen {
       // Force the compiler to use the above overload for std::span<std::byte const>
       template<std::ranges::sized_range R>
       write_buffer &put(R const &range) {
-         auto const recovery_position = position();
-         try {
-            put(std::ranges::size(range));
-            if constexpr (is_safe_to_copy<R>()) {
-               std::ranges::copy(range, buffer_.subspan(position_));
-               advance(std::ranges::size(range));
+         check(try_put(range));
+         return *this;
+      }
+
+      template<std::ranges::sized_range R>
+      std::expected<void, buffer_error> try_put(R const &range) {
+         auto const n = static_cast<size_type>(std::ranges::size(range));
+         if constexpr (is_safe_to_copy<R>() || is_bulk_codable<R>()) {
+            using value_t = std::ranges::range_value_t<R>;
+            if (remaining() < sizeof(size_type) || (remaining() - sizeof(size_type)) / sizeof(value_t) < n) {
+               return std::unexpected{buffer_error::not_enough_space};
+            }
+            auto *const out = buffer_.data() + position_;
+            store(n, out);
+            advance(sizeof(size_type) + put_contiguous(range, out + sizeof(size_type)));
+            return {};
+         }
+         else {
+            auto const recovery_position = position();
+            auto result = try_put(n);
+            for (auto it = std::ranges::begin(range); result && it != std::ranges::end(range); ++it) {
+               result = try_put(*it);
             }
-            else {
-               std::ranges::for_each(range, [this](auto const &x) {
-                  put(x);
-               });
+            if (!result) {
+               position_ = recovery_position;
             }
-            return *this;
+            return result;
+         }
+      }
+
+      write_buffer &put_varint(std::integral auto const x) {
+         check(try_put_varint(x));
+         return *this;
+      }
+
+      std::expected<void, buffer_error> try_put_varint(std::integral auto const x) noexcept {
+         auto const value = varint_utilities::to_unsigned(x);
+         if (remaining() < varint_utilities::size(value)) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         advance(varint_utilities::encode(value, buffer_.data() + position_));
+         return {};
+      }
+
+      // Writes the number of values followed by each value as a varint, checking bounds once for the whole range
+      template<std::ranges::sized_range R>
+         requires std::integral<std::ranges::range_value_t<R> >
+      write_buffer &put_varint(R const &range) {
+         check(try_put_varint(range));
+         return *this;
+      }
+
+      template<std::ranges::sized_range R>
+         requires std::integral<std::ranges::range_value_t<R> >
+      std::expected<void, buffer_error> try_put_varint(R const &range) {
+         auto const n = static_cast<std::uint64_t>(std::ranges::size(range));
+         auto size = varint_utilities::size(n);
+         for (auto const x: range) {
+            size += varint_utilities::size(varint_utilities::to_unsigned(x));
+         }
+         if (remaining() < size) {
+            return std::unexpected{buffer_error::not_enough_space};
          }
-         catch (...) {
-            position_ = recovery_position;
-            throw;
+         auto *out = buffer_.data() + position_;
+         out += varint_utilities::encode(n, out);
+         for (auto const x: range) {
+            out += varint_utilities::encode(varint_utilities::to_unsigned(x), out);
          }
+         advance(size);
+         return {};
+      }
+
+      // Writes the scalar fields of x in order with no padding, checking bounds once for the whole record
+      template<fixed_size_record T>
+      write_buffer &put_record(T const &x) {
+         check(try_put_record(x));
+         return *this;
+      }
+
+      template<fixed_size_record T>
+      std::expected<void, buffer_error> try_put_record(T const &x) noexcept {
+         return try_reserve(record_utilities::size<T>(), [&x](unchecked_writer &writer) {
+            record_utilities::for_each_field(x, [&writer]<typename F>(F const field) {
+               writer.put(static_cast<record_utilities::encoded_type<F> >(field));
+            });
+         });
+      }
+
+      // Checks once that n bytes remain, then hands write an unchecked_writer over them and moves past what it wrote,
+      // which must be no more than n bytes
+      template<std::invocable<unchecked_writer &> F>
+      write_buffer &reserve(size_type const n, F &&write) {
+         check(try_reserve(n, std::forward<F>(write)));
+         return *this;
+      }
+
+      template<std::invocable<unchecked_writer &> F>
+      std::expected<void, buffer_error> try_reserve(size_type const n, F &&write) {
+         if (remaining() < n) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         auto *const start = buffer_.data() + position_;
+         unchecked_writer writer{start};
+         std::invoke(std::forward<F>(write), writer);
+         advance(static_cast<size_type>(writer.cursor_ - start));
+         return {};
       }
 
       [[nodiscard]]
@@ -403,8 +659,14 @@ namespace io::skizzay::identigen {
          return std::ranges::contiguous_range<R> && std::is_trivially_copyable_v<value_t> && 1 == sizeof(value_t);
       }
 
-      void validate_put_size(size_type const size) const {
-         if (remaining() < size) {
+      template<typename R>
+      static constexpr bool is_bulk_codable() {
+         using value_t = std::remove_cv_t<std::ranges::range_value_t<R>>;
+         return std::ranges::contiguous_range<R> && byte_order_utilities::is_bulk_codable<value_t>;
+      }
+
+      static void check(std::expected<void, buffer_error> const result) {
+         if (!result) {
             throw buffer_overflow{"Cannot put value into buffer, not enough space remaining"};
          }
       }
@@ -422,38 +684,103 @@ namespace io::skizzay::identigen {
          position_ += n;
       }
 
+      // Copies or bulk encodes the values of range to out, returning the number of bytes written
+      template<typename R>
+      static size_type put_contiguous(R const &range, std::byte *const out) noexcept {
+         if constexpr (is_safe_to_copy<R>()) {
+            auto const bytes = std::as_bytes(std::span{std::ranges::data(range), std::ranges::size(range)});
+            std::ranges::copy(bytes, out);
+            return bytes.size();
+         }
+         else {
+            auto const values = std::span{std::ranges::data(range), std::ranges::size(range)};
+            byte_order_utilities::encode<E>(std::span<std::ranges::range_value_t<R> const>{values}, out);
+            return values.size_bytes();
+         }
+      }
+
+      template<buffer_scalar T>
+      static void store(T const x, std::byte *const out) noexcept {
+         if constexpr (std::integral<T>) {
+            encode(x, out);
+         }
+         else if constexpr (std::same_as<T, float>) {
+            encode(std::bit_cast<std::uint32_t>(x), out);
+         }
+         else {
+            auto const parts = std::bit_cast<std::array<std::uint32_t, 2> >(x);
+            constexpr bool big_words_first = std::endian::big == std::endian::native || std::endian::big == float_word_order;
+            encode(parts[big_words_first == (std::endian::big == E) ? 0 : 1], out);
+            encode(parts[big_words_first == (std::endian::big == E) ? 1 : 0], out + sizeof(std::uint32_t));
+         }
+      }
+
       template<std::integral I>
-      void encode(I x) noexcept;
+      static void encode(I x, std::byte *out) noexcept;
 
       underlying_type buffer_;
       size_type position_;
    };
 
+   // Puts into bytes that reserve() has already bounds checked, so that no put in between branches
+   template<std::endian E>
+   class write_buffer<E>::unchecked_writer final {
+   public:
+      friend struct write_buffer;
+
+      unchecked_writer &put(buffer_scalar auto const x) noexcept {
+         store(x, cursor_);
+         cursor_ += sizeof(x);
+         return *this;
+      }
+
+      // Writes the number of values followed by the values, like write_buffer::put
+      template<std::ranges::contiguous_range R>
+         requires std::ranges::sized_range<R> && (is_safe_to_copy<R>() || is_bulk_codable<R>())
+      unchecked_writer &put(R const &range) noexcept {
+         put(static_cast<size_type>(std::ranges::size(range)));
+         cursor_ += put_contiguous(range, cursor_);
+         return *this;
+      }
+
+      unchecked_writer &put_varint(std::integral auto const x) noexcept {
+         cursor_ += varint_utilities::encode(varint_utilities::to_unsigned(x), cursor_);
+         return *this;
+      }
+
+   private:
+      explicit unchecked_writer(std::byte *const cursor) noexcept
+         : cursor_{cursor} {
+      }
+
+      std::byte *cursor_;
+   };
+
    template<>
    template<std::integral I>
-   void write_buffer<std::endian::little>::encode(I const x) noexcept {
+   void write_buffer<std::endian::little>::encode(I const x, std::byte *const out) noexcept {
       if constexpr (8 == sizeof(I)) {
-         buffer_[position() + 7] = static_cast<std::byte>(x >> 56);
-         buffer_[position() + 6] = static_cast<std::byte>(x >> 48);
-         buffer_[position() + 5] = static_cast<std::byte>(x >> 40);
-         buffer_[position() + 4] = static_cast<std::byte>(x >> 32);
-         buffer_[position() + 3] = static_cast<std::byte>(x >> 24);
-         buffer_[position() + 2] = static_cast<std::byte>(x >> 16);
-         buffer_[position() + 1] = static_cast<std::byte>(x >> 8);
-         buffer_[position()] = static_cast<std::byte>(x);
+         out[7] = static_cast<std::byte>(x >> 56);
+         out[6] = static_cast<std::byte>(x >> 48);
+         out[5] = static_cast<std::byte>(x >> 40);
+         out[4] = static_cast<std::byte>(x >> 32);
+         out[3] = static_cast<std::byte>(x >> 24);
+         out[2] = static_cast<std::byte>(x >> 16);
+         out[1] = static_cast<std::byte>(x >> 8);
+         out[0] = static_cast<std::byte>(x);
       }
       else if constexpr (4 == sizeof(I)) {
-         buffer_[position() + 3] = static_cast<std::byte>(x >> 24);
-         buffer_[position() + 2] = static_cast<std::byte>(x >> 16);
-         buffer_[position() + 1] = static_cast<std::byte>(x >> 8);
-         buffer_[position()] = static_cast<std::byte>(x);
+         out[3] = static_cast<std::byte>(x >> 24);
+         out[2] = static_cast<std::byte>(x >> 16);
+         out[1] = static_cast<std::byte>(x >> 8);
+         out[0] = static_cast<std::byte>(x);
       }
       else if constexpr (2 == sizeof(I)) {
-         buffer_[position() + 1] = static_cast<std::byte>(x >> 8);
-         buffer_[position()] = static_cast<std::byte>(x);
+         out[1] = static_cast<std::byte>(x >> 8);
+         out[0] = static_cast<std::byte>(x);
       }
       else if constexpr (1 == sizeof(I)) {
-         buffer_[position()] = static_cast<std::byte>(x);
+         out[0] = static_cast<std::byte>(x);
       }
       else {
          static_assert(8 == sizeof(I), "Invalid integral size");
@@ -463,29 +790,29 @@ namespace io::skizzay::identigen {
 
    template<>
    template<std::integral I>
-   void write_buffer<std::endian::big>::encode(I const x) noexcept {
+   void write_buffer<std::endian::big>::encode(I const x, std::byte *const out) noexcept {
       if constexpr (1 == sizeof(I)) {
-         buffer_[position()] = static_cast<std::byte>(x);
+         out[0] = static_cast<std::byte>(x);
       }
       else if constexpr (2 == sizeof(I)) {
-         buffer_[position()] = static_cast<std::byte>(x >> 8);
-         buffer_[position() + 1] = static_cast<std::byte>(x);
+         out[0] = static_cast<std::byte>(x >> 8);
+         out[1] = static_cast<std::byte>(x);
       }
       else if constexpr (4 == sizeof(I)) {
-         buffer_[position()] = static_cast<std::byte>(x >> 24);
-         buffer_[position() + 1] = static_cast<std::byte>(x >> 16);
-         buffer_[position() + 2] = static_cast<std::byte>(x >> 8);
-         buffer_[position() + 3] = static_cast<std::byte>(x);
+         out[0] = static_cast<std::byte>(x >> 24);
+         out[1] = static_cast<std::byte>(x >> 16);
+         out[2] = static_cast<std::byte>(x >> 8);
+         out[3] = static_cast<std::byte>(x);
       }
       else if constexpr (8 == sizeof(I)) {
-         buffer_[position()] = static_cast<std::byte>(x >> 56);
-         buffer_[position() + 1] = static_cast<std::byte>(x >> 48);
-         buffer_[position() + 2] = static_cast<std::byte>(x >> 40);
-         buffer_[position() + 3] = static_cast<std::byte>(x >> 32);
-         buffer_[position() + 4] = static_cast<std::byte>(x >> 24);
-         buffer_[position() + 5] = static_cast<std::byte>(x >> 16);
-         buffer_[position() + 6] = static_cast<std::byte>(x >> 8);
-         buffer_[position() + 7] = static_cast<std::byte>(x);
+         out[0] = static_cast<std::byte>(x >> 56);
+         out[1] = static_cast<std::byte>(x >> 48);
+         out[2] = static_cast<std::byte>(x >> 40);
+         out[3] = static_cast<std::byte>(x >> 32);
+         out[4] = static_cast<std::byte>(x >> 24);
+         out[5] = static_cast<std::byte>(x >> 16);
+         out[6] = static_cast<std::byte>(x >> 8);
+         out[7] = static_cast<std::byte>(x);
       }
       else {
          static_assert(8 == sizeof(I), "Invalid integral size");
@@ -0,0 +1,188 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#if __has_include(<ieee754.h>)
+#include <ieee754.h>
+#endif
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace io::skizzay::identigen {
+   constexpr inline std::endian float_word_order = []() -> std::endian {
+      if constexpr (std::endian::big == std::endian::native) {
+         return std::endian::big;
+      }
+      else {
+         // I've spent too much time on this, and I'm not sure if it's even possible to detect the float word order
+         // without using preprocessor macros.
+         return __FLOAT_WORD_ORDER == __ORDER_BIG_ENDIAN__ ? std::endian::big : std::endian::little;
+      }
+   }();
+
+   struct byte_order_utilities {
+      byte_order_utilities() = delete;
+
+      // Types whose encoding in byte order E is their native representation with the bytes reversed when E is not
+      // native. Floating point only qualifies where its word order matches the integer byte order.
+      template<typename T>
+      static constexpr bool is_bulk_codable = (std::integral<T> && !std::same_as<T, bool>) || (
+                                                 std::floating_point<T> && float_word_order == std::endian::native &&
+                                                 (4 == sizeof(T) || 8 == sizeof(T)));
+
+      // Writes values into out in byte order E, copying straight through when E is native and otherwise reversing the
+      // bytes of each value with the widest shuffle the target supports (AVX2, SSSE3 or NEON).
+      template<std::endian E, typename T>
+         requires is_bulk_codable<T>
+      static void encode(std::span<T const> const values, std::byte *const out) noexcept {
+         copy<E, sizeof(T)>(reinterpret_cast<std::byte const *>(values.data()), out, values.size());
+      }
+
+      // Reads values.size() values from in, stored in byte order E
+      template<std::endian E, typename T>
+         requires is_bulk_codable<T>
+      static void decode(std::byte const *const in, std::span<T> const values) noexcept {
+         copy<E, sizeof(T)>(in, reinterpret_cast<std::byte *>(values.data()), values.size());
+      }
+
+   private:
+      template<std::endian E, std::size_t Width>
+      static void copy(std::byte const *const in, std::byte *const out, std::size_t const n) noexcept {
+         if constexpr (std::endian::native == E || 1 == Width) {
+            if (0 != n) {
+               std::memcpy(out, in, n * Width);
+            }
+         }
+         else {
+            reverse<Width>(in, out, n);
+         }
+      }
+
+      // Shuffle control reversing every Width-byte lane of a Size-byte vector
+      template<std::size_t Width, std::size_t Size>
+      static constexpr std::array<char, Size> reversal_control() noexcept {
+         std::array<char, Size> result = {};
+         for (std::size_t i = 0; i < Size; ++i) {
+            result[i] = static_cast<char>(i / Width * Width + Width - 1 - i % Width);
+         }
+         return result;
+      }
+
+      template<std::size_t Width>
+      static void reverse(std::byte const *const in, std::byte *const out, std::size_t const n) noexcept {
+         std::size_t i = 0;
+#if defined(__AVX2__)
+         {
+            static constexpr auto control_bytes = reversal_control<Width, 32>();
+            auto const control = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(control_bytes.data()));
+            for (constexpr std::size_t lanes = 32 / Width; i + lanes <= n; i += lanes) {
+               auto const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + i * Width));
+               _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * Width), _mm256_shuffle_epi8(v, control));
+            }
+         }
+#endif
+#if defined(__SSSE3__)
+         {
+            static constexpr auto control_bytes = reversal_control<Width, 16>();
+            auto const control = _mm_loadu_si128(reinterpret_cast<__m128i const *>(control_bytes.data()));
+            for (constexpr std::size_t lanes = 16 / Width; i + lanes <= n; i += lanes) {
+               auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + i * Width));
+               _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * Width), _mm_shuffle_epi8(v, control));
+            }
+         }
+#elif defined(__ARM_NEON)
+         for (constexpr std::size_t lanes = 16 / Width; i + lanes <= n; i += lanes) {
+            auto const v = vld1q_u8(reinterpret_cast<std::uint8_t const *>(in + i * Width));
+            auto *const o = reinterpret_cast<std::uint8_t *>(out + i * Width);
+            if constexpr (2 == Width) {
+               vst1q_u8(o, vrev16q_u8(v));
+            }
+            else if constexpr (4 == Width) {
+               vst1q_u8(o, vrev32q_u8(v));
+            }
+            else {
+               vst1q_u8(o, vrev64q_u8(v));
+            }
+         }
+#endif
+         using word = std::conditional_t<2 == Width, std::uint16_t,
+                                         std::conditional_t<4 == Width, std::uint32_t, std::uint64_t> >;
+         static_assert(sizeof(word) == Width, "Invalid integral size");
+         for (; i < n; ++i) {
+            word x;
+            std::memcpy(&x, in + i * Width, Width);
+            x = std::byteswap(x);
+            std::memcpy(out + i * Width, &x, Width);
+         }
+      }
+   };
+
+   // Integer stored in byte order E whatever the host's, for overlaying packed structs on encoded bytes without decoding
+   // them. Its alignment is one, so a struct of these has no padding and sits at any offset, and the bytes are only
+   // reordered when the value is read or assigned.
+   template<std::integral T, std::endian E>
+      requires (!std::same_as<T, bool>)
+   class endian_value final {
+   public:
+      using value_type = T;
+
+      static constexpr std::endian byte_order = E;
+
+      endian_value() noexcept = default;
+
+      constexpr endian_value(T const x) noexcept
+         : bytes_{std::bit_cast<std::array<std::byte, sizeof(T)> >(convert(x))} {
+      }
+
+      constexpr endian_value &operator=(T const x) noexcept {
+         bytes_ = std::bit_cast<std::array<std::byte, sizeof(T)> >(convert(x));
+         return *this;
+      }
+
+      [[nodiscard]]
+      constexpr T value() const noexcept {
+         return convert(std::bit_cast<T>(bytes_));
+      }
+
+      constexpr operator T() const noexcept {
+         return value();
+      }
+
+   private:
+      static constexpr T convert(T const x) noexcept {
+         if constexpr (std::endian::native == E || 1 == sizeof(T)) {
+            return x;
+         }
+         else {
+            return std::byteswap(x);
+         }
+      }
+
+      std::array<std::byte, sizeof(T)> bytes_;
+   };
+
+   template<std::integral T>
+   using big_endian = endian_value<T, std::endian::big>;
+
+   template<std::integral T>
+   using little_endian = endian_value<T, std::endian::little>;
+
+   // Types that can be laid over encoded bytes in place: trivially copyable with no alignment requirement, such as
+   // packed structs of endian_value and std::byte
+   template<typename T>
+   concept byte_overlay = std::is_trivially_copyable_v<T> && 1 == alignof(T);
+} // io::skizzay::identigen
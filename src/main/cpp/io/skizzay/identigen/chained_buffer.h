@@ -0,0 +1,340 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace io::skizzay::identigen {
+   // Free list of equally sized chunks, so that buffers built and dropped in a loop stop allocating once warm. Not
+   // thread-safe; local() gives every thread its own pool of default_chunk_size chunks.
+   class chunk_pool final {
+   public:
+      using chunk_type = std::unique_ptr<std::byte[]>;
+
+      static constexpr std::size_t default_chunk_size = 64 * 1024;
+      static constexpr std::size_t default_max_cached = 64;
+
+      explicit chunk_pool(std::size_t const chunk_size = default_chunk_size,
+                          std::size_t const max_cached = default_max_cached)
+         : chunk_size_{validate_chunk_size(chunk_size)},
+           max_cached_{max_cached} {
+      }
+
+      chunk_pool(chunk_pool const &) = delete;
+
+      chunk_pool &operator=(chunk_pool const &) = delete;
+
+      [[nodiscard]]
+      static chunk_pool &local() {
+         thread_local chunk_pool pool;
+         return pool;
+      }
+
+      [[nodiscard]]
+      std::size_t chunk_size() const noexcept {
+         return chunk_size_;
+      }
+
+      [[nodiscard]]
+      std::size_t num_cached() const noexcept {
+         return free_.size();
+      }
+
+      [[nodiscard]]
+      chunk_type acquire() {
+         if (free_.empty()) {
+            return std::make_unique_for_overwrite<std::byte[]>(chunk_size_);
+         }
+         auto chunk = std::move(free_.back());
+         free_.pop_back();
+         return chunk;
+      }
+
+      void release(chunk_type chunk) noexcept {
+         if (free_.size() < max_cached_) {
+            try {
+               free_.push_back(std::move(chunk));
+            }
+            catch (...) {
+               // Dropping the chunk frees it
+            }
+         }
+      }
+
+   private:
+      static std::size_t validate_chunk_size(std::size_t const chunk_size) {
+         if (chunk_size < minimum_chunk_size) {
+            throw std::invalid_argument{"Cannot create chunk pool, chunk size is too small"};
+         }
+         return chunk_size;
+      }
+
+      // Room for the widest scalar put, so that only ranges ever straddle more than two chunks
+      static constexpr std::size_t minimum_chunk_size = 16;
+
+      std::size_t const chunk_size_;
+      std::size_t const max_cached_;
+      std::vector<chunk_type> free_;
+   };
+
+   // Writer with the same put API as write_buffer<E> that never runs out of space: once a chunk is full it chains
+   // another from a chunk_pool, so growing never copies what has already been written. Values straddling two chunks
+   // are encoded into a scratch word and split; bulk ranges fill each chunk straight from the source. The result is
+   // the list of spans from to_input_buffers(), ready for writev through io_vector.
+   //
+   // By default chunks come from, and go back to, the thread-local pool of whichever thread is acquiring or
+   // releasing them, so the buffer may be handed between threads. With an explicit pool, only use the buffer on the
+   // pool's thread.
+   template<std::endian E>
+   class chained_write_buffer final {
+   public:
+      using size_type = std::size_t;
+
+      chained_write_buffer() noexcept = default;
+
+      explicit chained_write_buffer(chunk_pool &pool) noexcept
+         : pool_{&pool} {
+      }
+
+      chained_write_buffer(chained_write_buffer &&other) noexcept
+         : pool_{other.pool_},
+           chunks_{std::move(other.chunks_)},
+           sealed_{std::move(other.sealed_)},
+           open_{std::exchange(other.open_, 0)},
+           used_{std::exchange(other.used_, 0)},
+           size_{std::exchange(other.size_, 0)} {
+         other.chunks_.clear();
+         other.sealed_.clear();
+      }
+
+      chained_write_buffer &operator=(chained_write_buffer &&other) noexcept {
+         if (this != &other) {
+            release_chunks();
+            pool_ = other.pool_;
+            chunks_ = std::move(other.chunks_);
+            other.chunks_.clear();
+            sealed_ = std::move(other.sealed_);
+            other.sealed_.clear();
+            open_ = std::exchange(other.open_, 0);
+            used_ = std::exchange(other.used_, 0);
+            size_ = std::exchange(other.size_, 0);
+         }
+         return *this;
+      }
+
+      ~chained_write_buffer() {
+         release_chunks();
+      }
+
+      // Number of bytes written
+      [[nodiscard]]
+      size_type position() const noexcept {
+         return size_;
+      }
+
+      [[nodiscard]]
+      size_type num_chunks() const noexcept {
+         return chunks_.size();
+      }
+
+      chained_write_buffer &put(std::integral auto const x) {
+         return put_scalar(sizeof(x), [x](write_buffer<E> &writer) { writer.put(x); });
+      }
+
+      chained_write_buffer &put(float const x) {
+         return put_scalar(sizeof(x), [x](write_buffer<E> &writer) { writer.put(x); });
+      }
+
+      chained_write_buffer &put(double const x) {
+         return put_scalar(sizeof(x), [x](write_buffer<E> &writer) { writer.put(x); });
+      }
+
+      template<std::ranges::sized_range R>
+      chained_write_buffer &put(R const &range) {
+         using value_t = std::remove_cv_t<std::ranges::range_value_t<R> >;
+         put(std::ranges::size(range));
+         if constexpr (std::ranges::contiguous_range<R> && byte_order_utilities::is_bulk_codable<value_t>) {
+            put_bulk(std::span<value_t const>{std::ranges::data(range), std::ranges::size(range)});
+         }
+         else if constexpr (std::ranges::contiguous_range<R> && std::is_trivially_copyable_v<value_t> && 1 == sizeof(
+                               value_t)) {
+            put_bytes(std::as_bytes(std::span{std::ranges::data(range), std::ranges::size(range)}));
+         }
+         else {
+            std::ranges::for_each(range, [this](auto const &x) {
+               put(x);
+            });
+         }
+         return *this;
+      }
+
+      chained_write_buffer &put_varint(std::integral auto const x) {
+         auto const value = varint_utilities::to_unsigned(x);
+         return put_scalar(varint_utilities::size(value), [value](write_buffer<E> &writer) {
+            writer.put_varint(value);
+         });
+      }
+
+      template<std::ranges::sized_range R>
+         requires std::integral<std::ranges::range_value_t<R> >
+      chained_write_buffer &put_varint(R const &range) {
+         put_varint(static_cast<std::uint64_t>(std::ranges::size(range)));
+         for (auto const x: range) {
+            put_varint(x);
+         }
+         return *this;
+      }
+
+      // Writes the length of range like put(range), but only refers to its bytes instead of copying them, so range
+      // must outlive every use of to_input_buffers(). Worth it for payloads of a few KiB and up, which are then
+      // gathered by writev straight from where they lie.
+      template<std::ranges::contiguous_range R>
+         requires std::ranges::sized_range<R> && (
+                     1 == sizeof(std::ranges::range_value_t<R>) || (
+                        std::endian::native == E && byte_order_utilities::is_bulk_codable<std::remove_cv_t<
+                           std::ranges::range_value_t<R> > >))
+      chained_write_buffer &put_reference(R const &range) {
+         auto const bytes = std::as_bytes(std::span{std::ranges::data(range), std::ranges::size(range)});
+         put(std::ranges::size(range));
+         if (!bytes.empty()) {
+            seal();
+            sealed_.push_back(bytes);
+            size_ += bytes.size();
+         }
+         return *this;
+      }
+
+      // The bytes written so far in order: one span per run of a chunk between references, and one per reference
+      [[nodiscard]]
+      std::vector<std::span<std::byte const> > to_input_buffers() const {
+         std::vector<std::span<std::byte const> > result;
+         result.reserve(sealed_.size() + 1);
+         result.insert(result.end(), sealed_.begin(), sealed_.end());
+         if (open_ < used_) {
+            result.emplace_back(chunks_.back().get() + open_, used_ - open_);
+         }
+         return result;
+      }
+
+   private:
+      static constexpr std::size_t max_scalar_size = 16;
+
+      [[nodiscard]]
+      chunk_pool &pool() const {
+         return nullptr == pool_ ? chunk_pool::local() : *pool_;
+      }
+
+      [[nodiscard]]
+      std::size_t chunk_size() const {
+         return pool().chunk_size();
+      }
+
+      [[nodiscard]]
+      std::size_t available() const {
+         return chunks_.empty() ? 0 : chunk_size() - used_;
+      }
+
+      [[nodiscard]]
+      std::byte *cursor() const noexcept {
+         return chunks_.back().get() + used_;
+      }
+
+      void next_chunk() {
+         chunks_.reserve(chunks_.size() + 1);
+         sealed_.reserve(sealed_.size() + 1);
+         seal();
+         chunks_.push_back(pool().acquire());
+         open_ = 0;
+         used_ = 0;
+      }
+
+      // Closes the run of the current chunk written since the last reference
+      void seal() {
+         if (open_ < used_) {
+            sealed_.emplace_back(chunks_.back().get() + open_, used_ - open_);
+            open_ = used_;
+         }
+      }
+
+      void commit(std::size_t const n) noexcept {
+         used_ += n;
+         size_ += n;
+      }
+
+      // Encodes a value of n bytes in place, or through a scratch word when it would straddle two chunks
+      template<typename Encode>
+      chained_write_buffer &put_scalar(std::size_t const n, Encode const &encode) {
+         if (n <= available()) {
+            write_buffer<E> writer{std::span{cursor(), n}};
+            encode(writer);
+            commit(n);
+         }
+         else {
+            std::array<std::byte, max_scalar_size> scratch;
+            write_buffer<E> writer{std::span{scratch}.first(n)};
+            encode(writer);
+            put_bytes(std::span<std::byte const>{scratch}.first(n));
+         }
+         return *this;
+      }
+
+      void put_bytes(std::span<std::byte const> bytes) {
+         while (!bytes.empty()) {
+            if (0 == available()) {
+               next_chunk();
+            }
+            auto const n = std::min(bytes.size(), available());
+            std::memcpy(cursor(), bytes.data(), n);
+            commit(n);
+            bytes = bytes.subspan(n);
+         }
+      }
+
+      template<typename T>
+      void put_bulk(std::span<T const> values) {
+         while (!values.empty()) {
+            if (0 == available()) {
+               next_chunk();
+            }
+            auto const n = std::min(values.size(), available() / sizeof(T));
+            byte_order_utilities::encode<E>(values.first(n), cursor());
+            commit(n * sizeof(T));
+            values = values.subspan(n);
+            if (!values.empty() && 0 < available() && available() < sizeof(T)) {
+               put(values.front());
+               values = values.subspan(1);
+            }
+         }
+      }
+
+      void release_chunks() noexcept {
+         for (auto &chunk: chunks_) {
+            pool().release(std::move(chunk));
+         }
+         chunks_.clear();
+         sealed_.clear();
+      }
+
+      chunk_pool *pool_ = nullptr;
+      std::vector<chunk_pool::chunk_type> chunks_;
+      std::vector<std::span<std::byte const> > sealed_;
+      std::size_t open_ = 0;
+      std::size_t used_ = 0;
+      std::size_t size_ = 0;
+   };
+} // io::skizzay::identigen
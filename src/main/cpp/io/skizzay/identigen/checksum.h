@@ -0,0 +1,553 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#if defined(__SSE4_2__) || defined(__PCLMUL__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace io::skizzay::identigen {
+   struct checksum_mismatch : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   // Incremental checksums over runs of bytes: feeding a region in any number of pieces gives the same value as
+   // feeding it whole
+   template<typename C>
+   concept checksum = std::default_initializable<C> && std::unsigned_integral<typename C::value_type> &&
+                      requires(C c, C const &cc, std::span<std::byte const> const bytes) {
+                         { c.update(bytes) } -> std::same_as<C &>;
+                         { cc.value() } -> std::same_as<typename C::value_type>;
+                      };
+
+   // CRC32C (Castagnoli), as used by iSCSI, ext4 and most storage formats. With SSE4.2 or the ARMv8 CRC extension,
+   // large regions are split into three streams run through the CRC instruction in parallel, hiding its latency, and
+   // the three CRCs are combined by multiplying by x^(8n) mod P (one carry-less multiply where PCLMUL is available).
+   // Elsewhere it falls back to slicing-by-8 tables.
+   class crc32c final {
+   public:
+      using value_type = std::uint32_t;
+
+      crc32c &update(std::span<std::byte const> const bytes) noexcept {
+         state_ = extend(state_, bytes.data(), bytes.size());
+         return *this;
+      }
+
+      [[nodiscard]]
+      value_type value() const noexcept {
+         return ~state_;
+      }
+
+      [[nodiscard]]
+      static value_type compute(std::span<std::byte const> const bytes) noexcept {
+         return crc32c{}.update(bytes).value();
+      }
+
+   private:
+      // Bit-reflected Castagnoli polynomial
+      static constexpr std::uint32_t polynomial = 0x82f63b78;
+
+      // Bytes per stream when the CRC instruction runs three streams at once
+      static constexpr std::size_t long_stream = 8192;
+      static constexpr std::size_t short_stream = 256;
+
+      // x^n mod P, bit-reflected
+      static constexpr std::uint32_t x_to_the(std::size_t n) noexcept {
+         std::uint32_t x = 0x80000000;
+         for (; 0 < n; --n) {
+            x = 0 == (x & 1) ? x >> 1 : (x >> 1) ^ polynomial;
+         }
+         return x;
+      }
+
+      // a * b mod P, bit-reflected
+      static constexpr std::uint32_t multiply(std::uint32_t const a, std::uint32_t b) noexcept {
+         std::uint32_t product = 0;
+         for (std::uint32_t m = 0x80000000; 0 != m; m >>= 1) {
+            if (0 != (a & m)) {
+               product ^= b;
+            }
+            b = 0 == (b & 1) ? b >> 1 : (b >> 1) ^ polynomial;
+         }
+         return product;
+      }
+
+      static constexpr auto tables = [] {
+         std::array<std::array<std::uint32_t, 256>, 8> result = {};
+         for (std::uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+               crc = 0 == (crc & 1) ? crc >> 1 : (crc >> 1) ^ polynomial;
+            }
+            result[0][i] = crc;
+         }
+         for (std::size_t t = 1; t < result.size(); ++t) {
+            for (std::size_t i = 0; i < 256; ++i) {
+               result[t][i] = (result[t - 1][i] >> 8) ^ result[0][result[t - 1][i] & 0xff];
+            }
+         }
+         return result;
+      }();
+
+      static std::uint64_t load_little(std::byte const *const in) noexcept {
+         std::uint64_t word;
+         std::memcpy(&word, in, sizeof(word));
+         if constexpr (std::endian::big == std::endian::native) {
+            word = std::byteswap(word);
+         }
+         return word;
+      }
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+      static std::uint32_t step(std::uint32_t const crc, std::uint64_t const word) noexcept {
+#if defined(__SSE4_2__)
+         return static_cast<std::uint32_t>(_mm_crc32_u64(crc, word));
+#else
+         return __crc32cd(crc, word);
+#endif
+      }
+
+      static std::uint32_t step(std::uint32_t const crc, std::byte const b) noexcept {
+#if defined(__SSE4_2__)
+         return _mm_crc32_u8(crc, static_cast<std::uint8_t>(b));
+#else
+         return __crc32cb(crc, static_cast<std::uint8_t>(b));
+#endif
+      }
+
+      // The CRC of crc followed by Stream zero bytes
+      template<std::size_t Stream>
+      static std::uint32_t shift(std::uint32_t const crc) noexcept {
+#if defined(__SSE4_2__) && defined(__PCLMUL__)
+         // The 63-bit product of crc and x^(8n - 33) reduces to crc * x^(8n) through one CRC step
+         static constexpr auto factor = x_to_the(8 * Stream - 33);
+         auto const product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+                                                   _mm_cvtsi32_si128(static_cast<int>(factor)), 0);
+         return step(0, static_cast<std::uint64_t>(_mm_cvtsi128_si64(product)));
+#else
+         static constexpr auto factor = x_to_the(8 * Stream);
+         return multiply(factor, crc);
+#endif
+      }
+
+      template<std::size_t Stream>
+      static std::uint32_t extend_streams(std::uint32_t crc, std::byte const *&in, std::size_t &n) noexcept {
+         while (3 * Stream <= n) {
+            std::uint32_t crc1 = 0;
+            std::uint32_t crc2 = 0;
+            for (std::size_t i = 0; i < Stream; i += sizeof(std::uint64_t)) {
+               crc = step(crc, load_little(in + i));
+               crc1 = step(crc1, load_little(in + Stream + i));
+               crc2 = step(crc2, load_little(in + 2 * Stream + i));
+            }
+            crc = shift<Stream>(shift<Stream>(crc) ^ crc1) ^ crc2;
+            in += 3 * Stream;
+            n -= 3 * Stream;
+         }
+         return crc;
+      }
+
+      static std::uint32_t extend(std::uint32_t crc, std::byte const *in, std::size_t n) noexcept {
+         crc = extend_streams<long_stream>(crc, in, n);
+         crc = extend_streams<short_stream>(crc, in, n);
+         for (; sizeof(std::uint64_t) <= n; in += sizeof(std::uint64_t), n -= sizeof(std::uint64_t)) {
+            crc = step(crc, load_little(in));
+         }
+         for (; 0 < n; ++in, --n) {
+            crc = step(crc, *in);
+         }
+         return crc;
+      }
+#else
+      static std::uint32_t extend(std::uint32_t crc, std::byte const *in, std::size_t n) noexcept {
+         for (; sizeof(std::uint64_t) <= n; in += sizeof(std::uint64_t), n -= sizeof(std::uint64_t)) {
+            auto const word = load_little(in) ^ crc;
+            crc = tables[7][word & 0xff] ^ tables[6][(word >> 8) & 0xff] ^ tables[5][(word >> 16) & 0xff] ^
+                  tables[4][(word >> 24) & 0xff] ^ tables[3][(word >> 32) & 0xff] ^ tables[2][(word >> 40) & 0xff] ^
+                  tables[1][(word >> 48) & 0xff] ^ tables[0][word >> 56];
+         }
+         for (; 0 < n; ++in, --n) {
+            crc = (crc >> 8) ^ tables[0][(crc ^ static_cast<std::uint8_t>(*in)) & 0xff];
+         }
+         return crc;
+      }
+#endif
+
+      std::uint32_t state_ = ~std::uint32_t{};
+   };
+
+   // XXH3 64-bit with the default secret and no seed, matching XXH3_64bits from the reference xxHash. Long inputs
+   // are consumed a 64-byte stripe at a time into eight accumulators (vectorised with AVX2 where available); updates
+   // are buffered so that a region fed in pieces hashes exactly as if fed whole.
+   class xxh3 final {
+   public:
+      using value_type = std::uint64_t;
+
+      xxh3 &update(std::span<std::byte const> bytes) noexcept {
+         total_ += bytes.size();
+         if (bytes.size() <= buffer_size - buffered_) {
+            std::ranges::copy(bytes, buffer_.begin() + buffered_);
+            buffered_ += bytes.size();
+            return *this;
+         }
+         if (0 < buffered_) {
+            auto const fill = buffer_size - buffered_;
+            std::ranges::copy(bytes.first(fill), buffer_.begin() + buffered_);
+            bytes = bytes.subspan(fill);
+            stripes_ = consume_stripes(accumulators_, buffer_.data(), buffer_size / stripe_size, stripes_);
+            buffered_ = 0;
+         }
+         if (buffer_size < bytes.size()) {
+            do {
+               stripes_ = consume_stripes(accumulators_, bytes.data(), buffer_size / stripe_size, stripes_);
+               bytes = bytes.subspan(buffer_size);
+            } while (buffer_size < bytes.size());
+            // Keep the last stripe consumed, in case it is needed to complete the final one
+            std::memcpy(buffer_.data() + buffer_size - stripe_size, bytes.data() - stripe_size, stripe_size);
+         }
+         std::ranges::copy(bytes, buffer_.begin());
+         buffered_ = bytes.size();
+         return *this;
+      }
+
+      [[nodiscard]]
+      value_type value() const noexcept {
+         if (total_ <= mid_size_max) {
+            return compute(std::span{buffer_}.first(buffered_));
+         }
+         auto accumulators = accumulators_;
+         if (stripe_size <= buffered_) {
+            consume_stripes(accumulators, buffer_.data(), (buffered_ - 1) / stripe_size, stripes_);
+            accumulate(accumulators, buffer_.data() + buffered_ - stripe_size,
+                       secret.data() + secret.size() - stripe_size - last_stripe_secret_start);
+         }
+         else {
+            std::array<std::byte, stripe_size> last_stripe;
+            auto const catch_up = stripe_size - buffered_;
+            std::memcpy(last_stripe.data(), buffer_.data() + buffer_size - catch_up, catch_up);
+            std::memcpy(last_stripe.data() + catch_up, buffer_.data(), buffered_);
+            accumulate(accumulators, last_stripe.data(),
+                       secret.data() + secret.size() - stripe_size - last_stripe_secret_start);
+         }
+         return merge(accumulators, total_ * prime64_1);
+      }
+
+      [[nodiscard]]
+      static value_type compute(std::span<std::byte const> const bytes) noexcept {
+         auto const *const in = bytes.data();
+         auto const n = bytes.size();
+         if (n <= 16) {
+            return hash_short(in, n);
+         }
+         if (n <= 128) {
+            auto acc = n * prime64_1;
+            if (32 < n) {
+               if (64 < n) {
+                  if (96 < n) {
+                     acc += mix16(in + 48, secret.data() + 96);
+                     acc += mix16(in + n - 64, secret.data() + 112);
+                  }
+                  acc += mix16(in + 32, secret.data() + 64);
+                  acc += mix16(in + n - 48, secret.data() + 80);
+               }
+               acc += mix16(in + 16, secret.data() + 32);
+               acc += mix16(in + n - 32, secret.data() + 48);
+            }
+            acc += mix16(in, secret.data());
+            acc += mix16(in + n - 16, secret.data() + 16);
+            return avalanche(acc);
+         }
+         if (n <= mid_size_max) {
+            auto acc = n * prime64_1;
+            for (std::size_t i = 0; i < 8; ++i) {
+               acc += mix16(in + 16 * i, secret.data() + 16 * i);
+            }
+            acc = avalanche(acc);
+            for (std::size_t i = 8; i < n / 16; ++i) {
+               acc += mix16(in + 16 * i, secret.data() + 16 * (i - 8) + 3);
+            }
+            acc += mix16(in + n - 16, secret.data() + 136 - 17);
+            return avalanche(acc);
+         }
+         auto accumulators = initial_accumulators;
+         constexpr auto block_size = stripe_size * stripes_per_block;
+         auto const num_blocks = (n - 1) / block_size;
+         for (std::size_t b = 0; b < num_blocks; ++b) {
+            accumulate_stripes(accumulators, in + b * block_size, secret.data(), stripes_per_block);
+            scramble(accumulators, secret.data() + secret.size() - stripe_size);
+         }
+         accumulate_stripes(accumulators, in + num_blocks * block_size, secret.data(),
+                            (n - 1 - num_blocks * block_size) / stripe_size);
+         accumulate(accumulators, in + n - stripe_size,
+                    secret.data() + secret.size() - stripe_size - last_stripe_secret_start);
+         return merge(accumulators, n * prime64_1);
+      }
+
+   private:
+      using accumulators_type = std::array<std::uint64_t, 8>;
+
+      static constexpr std::size_t stripe_size = 64;
+      static constexpr std::size_t secret_consume_rate = 8;
+      static constexpr std::size_t buffer_size = 256;
+      static constexpr std::size_t mid_size_max = 240;
+      static constexpr std::size_t merge_secret_start = 11;
+      static constexpr std::size_t last_stripe_secret_start = 7;
+
+      static constexpr std::uint64_t prime32_1 = 0x9e3779b1;
+      static constexpr std::uint64_t prime32_2 = 0x85ebca77;
+      static constexpr std::uint64_t prime32_3 = 0xc2b2ae3d;
+      static constexpr std::uint64_t prime64_1 = 0x9e3779b185ebca87;
+      static constexpr std::uint64_t prime64_2 = 0xc2b2ae3d27d4eb4f;
+      static constexpr std::uint64_t prime64_3 = 0x165667b19e3779f9;
+      static constexpr std::uint64_t prime64_4 = 0x85ebca77c2b2ae63;
+      static constexpr std::uint64_t prime64_5 = 0x27d4eb2f165667c5;
+
+      static constexpr accumulators_type initial_accumulators = {
+         prime32_3, prime64_1, prime64_2, prime64_3, prime64_4, prime32_2, prime64_5, prime32_1
+      };
+
+      static constexpr auto secret = [] {
+         constexpr std::array<std::uint8_t, 192> bytes = {
+            0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+            0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+            0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+            0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+            0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+            0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+            0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+            0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+            0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+            0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+            0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+            0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+         };
+         std::array<std::byte, bytes.size()> result = {};
+         std::ranges::transform(bytes, result.begin(), [](auto const b) { return static_cast<std::byte>(b); });
+         return result;
+      }();
+
+      static constexpr std::size_t stripes_per_block = (secret.size() - stripe_size) / secret_consume_rate;
+
+      static std::uint64_t load64(std::byte const *const in) noexcept {
+         std::uint64_t x;
+         std::memcpy(&x, in, sizeof(x));
+         return std::endian::little == std::endian::native ? x : std::byteswap(x);
+      }
+
+      static std::uint64_t load32(std::byte const *const in) noexcept {
+         std::uint32_t x;
+         std::memcpy(&x, in, sizeof(x));
+         return std::endian::little == std::endian::native ? x : std::byteswap(x);
+      }
+
+      static std::uint64_t fold(std::uint64_t const a, std::uint64_t const b) noexcept {
+         auto const product = static_cast<unsigned __int128>(a) * b;
+         return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+      }
+
+      static std::uint64_t avalanche(std::uint64_t x) noexcept {
+         x ^= x >> 37;
+         x *= 0x165667919e3779f9;
+         return x ^ (x >> 32);
+      }
+
+      static std::uint64_t hash_short(std::byte const *const in, std::size_t const n) noexcept {
+         if (8 < n) {
+            auto const low = load64(in) ^ (load64(secret.data() + 24) ^ load64(secret.data() + 32));
+            auto const high = load64(in + n - 8) ^ (load64(secret.data() + 40) ^ load64(secret.data() + 48));
+            return avalanche(n + std::byteswap(low) + high + fold(low, high));
+         }
+         if (4 <= n) {
+            auto x = ((load32(in + n - 4) + (load32(in) << 32)) ^
+                      (load64(secret.data() + 8) ^ load64(secret.data() + 16)));
+            x ^= std::rotl(x, 49) ^ std::rotl(x, 24);
+            x *= 0x9fb21c651e98df25;
+            x ^= (x >> 35) + n;
+            x *= 0x9fb21c651e98df25;
+            return x ^ (x >> 28);
+         }
+         std::uint64_t x = load64(secret.data() + 56) ^ load64(secret.data() + 64);
+         if (0 < n) {
+            auto const combined = static_cast<std::uint32_t>(in[0]) << 16 | static_cast<std::uint32_t>(in[n >> 1]) << 24 |
+                                  static_cast<std::uint32_t>(in[n - 1]) | static_cast<std::uint32_t>(n) << 8;
+            x = combined ^ (load32(secret.data()) ^ load32(secret.data() + 4));
+         }
+         x ^= x >> 33;
+         x *= prime64_2;
+         x ^= x >> 29;
+         x *= prime64_3;
+         return x ^ (x >> 32);
+      }
+
+      static std::uint64_t mix16(std::byte const *const in, std::byte const *const key) noexcept {
+         return fold(load64(in) ^ load64(key), load64(in + 8) ^ load64(key + 8));
+      }
+
+      static void accumulate(accumulators_type &accumulators, std::byte const *const in,
+                             std::byte const *const key) noexcept {
+#if defined(__AVX2__)
+         for (std::size_t i = 0; i < accumulators.size(); i += 4) {
+            auto const data = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + 8 * i));
+            auto const keyed = _mm256_xor_si256(data, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(key + 8 * i)));
+            auto const product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+            auto const swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            auto *const acc = reinterpret_cast<__m256i *>(accumulators.data() + i);
+            _mm256_storeu_si256(acc, _mm256_add_epi64(_mm256_add_epi64(_mm256_loadu_si256(acc), swapped), product));
+         }
+#else
+         for (std::size_t i = 0; i < accumulators.size(); ++i) {
+            auto const data = load64(in + 8 * i);
+            auto const keyed = data ^ load64(key + 8 * i);
+            accumulators[i ^ 1] += data;
+            accumulators[i] += (keyed & 0xffffffff) * (keyed >> 32);
+         }
+#endif
+      }
+
+      static void accumulate_stripes(accumulators_type &accumulators, std::byte const *const in,
+                                     std::byte const *const key, std::size_t const num_stripes) noexcept {
+         for (std::size_t s = 0; s < num_stripes; ++s) {
+            accumulate(accumulators, in + s * stripe_size, key + s * secret_consume_rate);
+         }
+      }
+
+      static void scramble(accumulators_type &accumulators, std::byte const *const key) noexcept {
+         for (std::size_t i = 0; i < accumulators.size(); ++i) {
+            auto x = accumulators[i];
+            x ^= x >> 47;
+            x ^= load64(key + 8 * i);
+            accumulators[i] = x * prime32_1;
+         }
+      }
+
+      // Accumulates num_stripes stripes, scrambling whenever a block's worth of secret has been used. Returns the
+      // number of stripes into the current block.
+      static std::size_t consume_stripes(accumulators_type &accumulators, std::byte const *const in,
+                                         std::size_t const num_stripes, std::size_t const stripes) noexcept {
+         if (stripes_per_block - stripes <= num_stripes) {
+            auto const to_end = stripes_per_block - stripes;
+            accumulate_stripes(accumulators, in, secret.data() + stripes * secret_consume_rate, to_end);
+            scramble(accumulators, secret.data() + secret.size() - stripe_size);
+            accumulate_stripes(accumulators, in + to_end * stripe_size, secret.data(), num_stripes - to_end);
+            return num_stripes - to_end;
+         }
+         accumulate_stripes(accumulators, in, secret.data() + stripes * secret_consume_rate, num_stripes);
+         return stripes + num_stripes;
+      }
+
+      static std::uint64_t merge(accumulators_type const &accumulators, std::uint64_t result) noexcept {
+         for (std::size_t i = 0; i < accumulators.size(); i += 2) {
+            auto const *const key = secret.data() + merge_secret_start + 8 * i;
+            result += fold(accumulators[i] ^ load64(key), accumulators[i + 1] ^ load64(key + 8));
+         }
+         return avalanche(result);
+      }
+
+      accumulators_type accumulators_ = initial_accumulators;
+      std::array<std::byte, buffer_size> buffer_;
+      std::size_t buffered_ = 0;
+      std::size_t stripes_ = 0;
+      std::uint64_t total_ = 0;
+   };
+
+   // Checksums what a write_buffer writes while it is still in cache: each update() folds in the bytes put since the
+   // previous one, so a batch can be checksummed piece by piece as sub-writers and records are filled in, rather
+   // than in a separate pass once it is complete.
+   template<checksum C, std::endian E>
+   class write_checksum final {
+   public:
+      using value_type = typename C::value_type;
+
+      explicit write_checksum(write_buffer<E> const &writer) noexcept
+         : writer_{writer},
+           mark_{writer.position()} {
+      }
+
+      write_checksum &update() {
+         checksum_.update(writer_.to_input_buffer(mark_));
+         mark_ = writer_.position();
+         return *this;
+      }
+
+      // Also folds in bytes written directly to the buffer's memory past the current position, such as those filled
+      // by a sub-writer whose bytes have not yet been claimed with position()
+      write_checksum &update(std::span<std::byte const> const bytes) {
+         checksum_.update(bytes);
+         return *this;
+      }
+
+      [[nodiscard]]
+      value_type value() {
+         return update().checksum_.value();
+      }
+
+      // Writes the checksum of everything written since construction to writer, which must be the tracked buffer
+      void put(write_buffer<E> &writer) {
+         writer.put(value());
+         mark_ = writer.position();
+      }
+
+   private:
+      write_buffer<E> const &writer_;
+      std::size_t mark_;
+      C checksum_;
+   };
+
+   // Checksums what a read_buffer reads, for verifying a checksum written by write_checksum::put
+   template<checksum C, std::endian E>
+   class read_checksum final {
+   public:
+      using value_type = typename C::value_type;
+
+      explicit read_checksum(read_buffer<E> const &reader) noexcept
+         : reader_{reader},
+           unread_{reader.available_bytes()},
+           start_{reader.position()} {
+      }
+
+      read_checksum &update() {
+         auto const read = reader_.position() - start_;
+         checksum_.update(unread_.subspan(hashed_, read - hashed_));
+         hashed_ = read;
+         return *this;
+      }
+
+      [[nodiscard]]
+      value_type value() {
+         return update().checksum_.value();
+      }
+
+      // Reads the stored checksum from reader, which must be the tracked buffer, and compares it with the checksum of
+      // everything read before it. Throws checksum_mismatch if they differ.
+      void verify(read_buffer<E> &reader) {
+         auto const expected = value();
+         if (static_cast<value_type>(reader.get()) != expected) {
+            throw checksum_mismatch{"Checksum does not match the bytes read"};
+         }
+         hashed_ = reader.position() - start_;
+      }
+
+   private:
+      read_buffer<E> const &reader_;
+      std::span<std::byte const> unread_;
+      std::size_t start_;
+      std::size_t hashed_ = 0;
+      C checksum_;
+   };
+} // io::skizzay::identigen
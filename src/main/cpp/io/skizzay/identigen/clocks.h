@@ -0,0 +1,232 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/timestamp_provider.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   // Timestamp provider reading a time point cached in an atomic, which a background thread refreshes from Clock every
+   // period. A read is a single relaxed load.
+   //
+   // Error bound: the cached value is floored to Duration and never runs ahead of Clock. It lags Clock::now() by at
+   // most period plus the wake-up latency of the ticker thread (typically tens of microseconds on an idle Linux host,
+   // unbounded under CPU starvation). It inherits any steps of Clock itself.
+   //
+   // The ticker thread refers back to the clock, so it can be neither copied nor moved; hand it to a generator
+   // through std::ref.
+   template<typename Clock = std::chrono::system_clock, typename Duration = std::chrono::milliseconds>
+   class ticker_clock final {
+   public:
+      using clock = Clock;
+      using duration = Duration;
+      using time_point = std::chrono::time_point<Clock, Duration>;
+
+      explicit ticker_clock(typename Clock::duration const period = std::chrono::duration_cast<typename Clock::duration>(
+                               Duration{1}))
+         : now_{sample()},
+           ticker_{[this, period](std::stop_token const token) {
+              std::mutex mutex;
+              std::unique_lock lock{mutex};
+              // Waits out the period unless the clock is being destroyed
+              while (!wakeup_.wait_for(lock, token, period, [&token] { return token.stop_requested(); })) {
+                 now_.store(sample(), std::memory_order_relaxed);
+              }
+           }} {
+      }
+
+      ticker_clock(ticker_clock const &) = delete;
+
+      ticker_clock &operator=(ticker_clock const &) = delete;
+
+      [[nodiscard]]
+      time_point operator()() const noexcept {
+         return time_point{Duration{now_.load(std::memory_order_relaxed)}};
+      }
+
+   private:
+      static typename Duration::rep sample() noexcept {
+         return std::chrono::floor<Duration>(Clock::now()).time_since_epoch().count();
+      }
+
+      std::atomic<typename Duration::rep> now_;
+      std::condition_variable_any wakeup_;
+      std::jthread ticker_;
+   };
+
+   // Timestamp provider extrapolating Clock from the CPU's cycle counter (TSC on x86, CNTVCT on AArch64, the steady
+   // clock elsewhere). The counter rate is calibrated against the steady clock at construction, so that steps of Clock
+   // cannot skew it, and the anchor is re-taken from Clock every resync period by a background thread. A read is a
+   // counter read, a 128-bit multiply and a seqlock.
+   //
+   // Error bound: between resyncs the error grows with the calibrated rate error, which is roughly the steady clock
+   // read jitter divided by the calibration baseline (about 1 ppm for a 10ms calibration, then improving with every
+   // resync as the baseline grows), i.e. about 1us for every second since the last resync. At each resync the provider
+   // steps onto Clock and may move backwards by that amount, or by however far Clock itself stepped. The counter must
+   // be invariant and synchronized across cores, which holds for any x86 CPU advertising constant_tsc and nonstop_tsc.
+   template<typename Clock = std::chrono::system_clock, typename Duration = std::chrono::nanoseconds>
+   class tsc_clock final {
+   public:
+      using clock = Clock;
+      using duration = Duration;
+      using time_point = std::chrono::time_point<Clock, Duration>;
+
+      explicit tsc_clock(std::chrono::nanoseconds const calibration = std::chrono::milliseconds{10},
+                         std::chrono::nanoseconds const resync_period = std::chrono::seconds{1}) {
+         auto const start = sample();
+         std::this_thread::sleep_for(calibration);
+         resync(start, sample());
+         resyncer_ = std::jthread{[this, start, resync_period](std::stop_token const token) {
+            std::mutex mutex;
+            std::unique_lock lock{mutex};
+            // Waits out the period unless the clock is being destroyed
+            while (!wakeup_.wait_for(lock, token, resync_period, [&token] { return token.stop_requested(); })) {
+               resync(start, sample());
+            }
+         }};
+      }
+
+      tsc_clock(tsc_clock const &) = delete;
+
+      tsc_clock &operator=(tsc_clock const &) = delete;
+
+      [[nodiscard]]
+      time_point operator()() const noexcept {
+         for (;;) {
+            auto const version = version_.load(std::memory_order_acquire);
+            auto const counter = anchor_counter_.load(std::memory_order_relaxed);
+            auto const nanoseconds = anchor_nanoseconds_.load(std::memory_order_relaxed);
+            auto const multiplier = multiplier_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (0 == (version & 1) && version == version_.load(std::memory_order_relaxed)) {
+               auto const ticks = static_cast<std::int64_t>(read_counter() - counter);
+               auto const elapsed = static_cast<std::int64_t>((static_cast<__int128>(ticks) * multiplier) >> fraction_bits);
+               return std::chrono::floor<Duration>(
+                  std::chrono::time_point<Clock, std::chrono::nanoseconds>{
+                     std::chrono::nanoseconds{nanoseconds + elapsed}
+                  });
+            }
+         }
+      }
+
+      // Cycle counter ticks per second as last calibrated
+      [[nodiscard]]
+      double frequency() const noexcept {
+         return static_cast<double>(std::uint64_t{1} << fraction_bits) * 1e9 /
+                static_cast<double>(multiplier_.load(std::memory_order_relaxed));
+      }
+
+      static std::uint64_t read_counter() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+         return __rdtsc();
+#elif defined(__aarch64__)
+         std::uint64_t result;
+         asm volatile("mrs %0, cntvct_el0" : "=r"(result));
+         return result;
+#else
+         return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+      }
+
+   private:
+      static constexpr unsigned fraction_bits = 32;
+
+      struct sample_type final {
+         std::uint64_t counter;
+         std::int64_t nanoseconds;
+         std::chrono::steady_clock::time_point steady;
+      };
+
+      // Brackets the clock reads between two counter reads to halve the sampling error
+      static sample_type sample() noexcept {
+         auto const before = read_counter();
+         auto const steady = std::chrono::steady_clock::now();
+         auto const now = std::chrono::time_point_cast<std::chrono::nanoseconds>(Clock::now());
+         auto const after = read_counter();
+         return {before + (after - before) / 2, now.time_since_epoch().count(), steady};
+      }
+
+      // Only ever called from one thread at a time: the constructor, then the resync thread
+      void resync(sample_type const &start, sample_type const &now) noexcept {
+         auto const ticks = now.counter - start.counter;
+         auto const nanoseconds = static_cast<unsigned __int128>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now.steady - start.steady).count());
+         auto const multiplier = 0 == ticks ? std::uint64_t{1} << fraction_bits
+                                            : static_cast<std::uint64_t>((nanoseconds << fraction_bits) / ticks);
+         auto const version = version_.load(std::memory_order_relaxed);
+         version_.store(version + 1, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_release);
+         anchor_counter_.store(now.counter, std::memory_order_relaxed);
+         anchor_nanoseconds_.store(now.nanoseconds, std::memory_order_relaxed);
+         multiplier_.store(multiplier, std::memory_order_relaxed);
+         version_.store(version + 2, std::memory_order_release);
+      }
+
+      std::atomic<std::uint64_t> version_ = 0;
+      std::atomic<std::uint64_t> anchor_counter_ = 0;
+      std::atomic<std::int64_t> anchor_nanoseconds_ = 0;
+      std::atomic<std::uint64_t> multiplier_ = std::uint64_t{1} << fraction_bits;
+      std::condition_variable_any wakeup_;
+      std::jthread resyncer_;
+   };
+
+   // Timestamp provider that never moves backwards: it returns the later of the underlying provider and the latest
+   // timestamp it has returned or observed. Observing the timestamps of remote events makes it the physical half of a
+   // hybrid logical clock, with a generator's sequence number as the logical half. Pair it with an unbounded
+   // clock_regression_policy::borrow so that exhausting the sequence carries into the next tick rather than waiting
+   // for the physical clock: generation then never stalls, however far the physical clock steps back, and IDs run
+   // ahead of it by at most the number of IDs issued since the step divided by the sequence size.
+   template<timestamp_provider TimestampProvider>
+   class hybrid_logical_clock final {
+   public:
+      using time_point = std::invoke_result_t<TimestampProvider &>;
+      using duration = typename time_point::duration;
+
+      explicit hybrid_logical_clock(TimestampProvider timestamp_provider)
+         : timestamp_provider_{std::move(timestamp_provider)},
+           latest_{timestamp_provider_().time_since_epoch().count()} {
+      }
+
+      hybrid_logical_clock(hybrid_logical_clock const &) = delete;
+
+      hybrid_logical_clock &operator=(hybrid_logical_clock const &) = delete;
+
+      [[nodiscard]]
+      time_point operator()() {
+         return time_point{duration{advance(timestamp_provider_().time_since_epoch().count())}};
+      }
+
+      // Merges the timestamp of a remote event, so that every later timestamp orders after it
+      void observe(time_point const remote) noexcept {
+         advance(remote.time_since_epoch().count());
+      }
+
+   private:
+      using rep = typename duration::rep;
+
+      rep advance(rep const now) noexcept {
+         auto latest = latest_.load(std::memory_order_relaxed);
+         while (latest < now && !latest_.compare_exchange_weak(latest, now, std::memory_order_relaxed)) {
+         }
+         return std::max(latest, now);
+      }
+
+      TimestampProvider timestamp_provider_;
+      std::atomic<rep> latest_;
+   };
+} // io::skizzay::identigen
@@ -0,0 +1,288 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   // Compresses 64-bit IDs that come out nearly sorted, such as those from a timestamp-leading layout. IDs are split
+   // into blocks of block_size; within a block each ID is stored as its difference from the ID four places before it
+   // (D4 deltas), less the block's smallest difference (frame of reference), bit-packed at the narrowest width that
+   // fits. The four interleaved delta streams are packed vertically, so word w of all four lanes sits in one 32-byte
+   // run and unpacking plus the prefix sum is one vector shift, mask and two adds per four IDs.
+   //
+   // Layout: the number of IDs as a varint, the byte offset of every block within the block data (a range of
+   // uint64_t), then the block data as a length-prefixed byte span. A block is its first ID, its reference, its bit
+   // width and the packed words, all in the buffer's byte order. Any block can be decoded on its own through
+   // delta_block_view.
+   struct delta_codec {
+      delta_codec() = delete;
+
+      static constexpr std::size_t block_size = 128;
+      static constexpr std::size_t num_lanes = 4;
+
+      template<std::endian E>
+      static void encode(write_buffer<E> &writer, std::span<std::uint64_t const> const ids) {
+         auto const num_blocks = (ids.size() + block_size - 1) / block_size;
+         std::vector<std::uint64_t> offsets(num_blocks);
+         std::uint64_t data_size = 0;
+         for (std::size_t i = 0; i < num_blocks; ++i) {
+            offsets[i] = data_size;
+            data_size += block_header_size + words_per_block(frame(block_ids(ids, i)).width) * sizeof(std::uint64_t);
+         }
+
+         auto const ids_size = varint_utilities::size(ids.size());
+         auto const offsets_size = sizeof(std::size_t) + offsets.size() * sizeof(std::uint64_t);
+         if (writer.remaining() < ids_size + offsets_size + sizeof(std::size_t) + data_size) {
+            throw buffer_overflow{"Cannot put IDs into buffer, not enough space remaining"};
+         }
+         writer.put_varint(ids.size());
+         writer.put(offsets);
+         writer.put(static_cast<std::size_t>(data_size));
+         auto data = writer.subwriter(writer.position(), data_size);
+         for (std::size_t i = 0; i < num_blocks; ++i) {
+            auto const b = block_ids(ids, i);
+            auto const f = frame(b);
+            data.put(b.front()).put(f.reference).put(f.width);
+            std::array<std::uint64_t, max_words> words;
+            pack(b, f, std::span{words}.first(words_per_block(f.width)));
+            for (auto const word: std::span{words}.first(words_per_block(f.width))) {
+               data.put(word);
+            }
+         }
+         writer.position(writer.position() + data_size);
+      }
+
+      // Decodes every ID into the front of ids and returns how many there were
+      template<std::endian E>
+      static std::size_t decode(read_buffer<E> &reader, std::span<std::uint64_t> ids);
+
+   private:
+      template<std::endian E>
+      friend class delta_block_view;
+
+      static constexpr std::size_t values_per_lane = block_size / num_lanes;
+      static constexpr std::size_t block_header_size = 2 * sizeof(std::uint64_t) + sizeof(std::uint8_t);
+      static constexpr std::size_t max_words = num_lanes * values_per_lane;
+
+      struct frame_type final {
+         std::uint64_t reference;
+         std::uint8_t width;
+      };
+
+      static constexpr std::size_t words_per_block(std::size_t const width) noexcept {
+         return num_lanes * ((values_per_lane * width + 63) / 64);
+      }
+
+      static std::span<std::uint64_t const> block_ids(std::span<std::uint64_t const> const ids,
+                                                      std::size_t const i) noexcept {
+         return ids.subspan(i * block_size, std::min(block_size, ids.size() - i * block_size));
+      }
+
+      static std::uint64_t delta(std::span<std::uint64_t const> const ids, std::size_t const i) noexcept {
+         return ids[i] - ids[num_lanes <= i ? i - num_lanes : 0];
+      }
+
+      // Smallest D4 delta of a block and the number of bits the deltas take once it is subtracted
+      static frame_type frame(std::span<std::uint64_t const> const ids) noexcept {
+         auto smallest = std::numeric_limits<std::int64_t>::max();
+         auto largest = std::numeric_limits<std::int64_t>::min();
+         for (std::size_t i = 0; i < ids.size(); ++i) {
+            auto const d = static_cast<std::int64_t>(delta(ids, i));
+            smallest = std::min(smallest, d);
+            largest = std::max(largest, d);
+         }
+         auto const spread = static_cast<std::uint64_t>(largest) - static_cast<std::uint64_t>(smallest);
+         return {static_cast<std::uint64_t>(smallest), static_cast<std::uint8_t>(std::bit_width(spread))};
+      }
+
+      // Packs the deltas of lane i % num_lanes into bit stream i % num_lanes; padding past the end packs as zero
+      static void pack(std::span<std::uint64_t const> const ids, frame_type const f,
+                       std::span<std::uint64_t> const words) noexcept {
+         std::ranges::fill(words, 0);
+         std::size_t const width = f.width;
+         for (std::size_t i = 0; i < ids.size() && 0 < width; ++i) {
+            auto const x = delta(ids, i) - f.reference;
+            auto const bit = i / num_lanes * width;
+            auto const w = bit / 64;
+            auto const s = bit % 64;
+            auto const lane = i % num_lanes;
+            words[w * num_lanes + lane] |= x << s;
+            if (64 < s + width) {
+               words[(w + 1) * num_lanes + lane] |= x >> (64 - s);
+            }
+         }
+      }
+
+      // Unpacks a block of deltas and prefix sums them, four lanes at a time
+      template<std::size_t Width>
+      static void unpack(std::uint64_t const *const words, std::uint64_t const first, std::uint64_t const reference,
+                         std::uint64_t *const out) noexcept {
+         constexpr auto mask = low_mask(Width);
+#if defined(__AVX2__)
+         auto previous = _mm256_set1_epi64x(static_cast<long long>(first));
+         auto const frame = _mm256_set1_epi64x(static_cast<long long>(reference));
+         auto const low_bits = _mm256_set1_epi64x(static_cast<long long>(mask));
+         for (std::size_t j = 0; j < values_per_lane; ++j) {
+            auto deltas = _mm256_setzero_si256();
+            if constexpr (0 < Width) {
+               auto const bit = j * Width;
+               auto const w = bit / 64;
+               auto const s = static_cast<int>(bit % 64);
+               deltas = _mm256_srli_epi64(
+                  _mm256_loadu_si256(reinterpret_cast<__m256i const *>(words + w * num_lanes)), s);
+               if (64 < s + static_cast<int>(Width)) {
+                  deltas = _mm256_or_si256(deltas, _mm256_slli_epi64(
+                                              _mm256_loadu_si256(
+                                                 reinterpret_cast<__m256i const *>(words + (w + 1) * num_lanes)),
+                                              64 - s));
+               }
+               deltas = _mm256_and_si256(deltas, low_bits);
+            }
+            previous = _mm256_add_epi64(previous, _mm256_add_epi64(deltas, frame));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + j * num_lanes), previous);
+         }
+#else
+         std::array<std::uint64_t, num_lanes> previous;
+         previous.fill(first);
+         for (std::size_t j = 0; j < values_per_lane; ++j) {
+            auto const bit = j * Width;
+            auto const w = bit / 64;
+            auto const s = bit % 64;
+            for (std::size_t lane = 0; lane < num_lanes; ++lane) {
+               std::uint64_t delta = 0;
+               if constexpr (0 < Width) {
+                  delta = words[w * num_lanes + lane] >> s;
+                  if (64 < s + Width) {
+                     delta |= words[(w + 1) * num_lanes + lane] << (64 - s);
+                  }
+                  delta &= mask;
+               }
+               previous[lane] += delta + reference;
+               out[j * num_lanes + lane] = previous[lane];
+            }
+         }
+#endif
+      }
+
+      static constexpr std::uint64_t low_mask(std::size_t const width) noexcept {
+         return 64 <= width ? ~std::uint64_t{} : (std::uint64_t{1} << width) - 1;
+      }
+
+      using unpack_function = void (*)(std::uint64_t const *, std::uint64_t, std::uint64_t, std::uint64_t *) noexcept;
+
+      static constexpr auto unpackers = []<std::size_t... W>(std::index_sequence<W...>) {
+         return std::array<unpack_function, sizeof...(W)>{&unpack<W>...};
+      }(std::make_index_sequence<65>{});
+   };
+
+   // Random access to the blocks written by delta_codec::encode. Construction reads the block index from the reader
+   // and moves it past the encoded IDs; the view refers to the reader's underlying bytes.
+   template<std::endian E>
+   class delta_block_view final {
+   public:
+      explicit delta_block_view(read_buffer<E> &reader) {
+         auto const recovery_position = reader.position();
+         try {
+            size_ = reader.template get_varint<std::size_t>();
+            auto const num_blocks = size_ / delta_codec::block_size + (0 != size_ % delta_codec::block_size);
+            // The size is untrusted, so the index is checked against it and the bytes left before allocating for it
+            read_buffer<E> index{reader.available_bytes()};
+            if (num_blocks != static_cast<std::size_t>(index.get())) {
+               throw std::out_of_range{"Cannot read IDs, block index does not match the number of IDs"};
+            }
+            if (index.remaining() / sizeof(std::uint64_t) < num_blocks) {
+               throw buffer_overflow{"Cannot read IDs, not enough space remaining"};
+            }
+            offsets_.resize(num_blocks);
+            reader.get(std::span{offsets_});
+            data_ = static_cast<std::span<std::byte const> >(reader.get());
+         }
+         catch (...) {
+            reader.position(recovery_position);
+            throw;
+         }
+      }
+
+      // Number of IDs
+      [[nodiscard]]
+      std::size_t size() const noexcept {
+         return size_;
+      }
+
+      [[nodiscard]]
+      std::size_t num_blocks() const noexcept {
+         return offsets_.size();
+      }
+
+      // Decodes block i into the front of ids, which needs room for the block's IDs, and returns how many there were
+      std::size_t block(std::size_t const i, std::span<std::uint64_t> const ids) const {
+         if (num_blocks() <= i) {
+            throw std::out_of_range{"Cannot read IDs, block index out of range"};
+         }
+         auto const n = std::min(delta_codec::block_size, size_ - i * delta_codec::block_size);
+         if (ids.size() < n) {
+            throw std::out_of_range{"Cannot read IDs, not enough space for the decoded IDs"};
+         }
+         if (data_.size() < offsets_[i]) {
+            throw buffer_overflow{"Cannot read IDs, block offset exceeds the block data"};
+         }
+         read_buffer<E> header{data_.subspan(offsets_[i])};
+         auto const first = static_cast<std::uint64_t>(header.get());
+         auto const reference = static_cast<std::uint64_t>(header.get());
+         auto const width = static_cast<std::uint8_t>(header.get());
+         if (64 < width) {
+            throw std::out_of_range{"Cannot read IDs, block bit width exceeds 64"};
+         }
+         auto const num_words = delta_codec::words_per_block(width);
+         if (header.remaining() < num_words * sizeof(std::uint64_t)) {
+            throw buffer_overflow{"Cannot read IDs, not enough space remaining"};
+         }
+         std::array<std::uint64_t, delta_codec::max_words> words;
+         byte_order_utilities::decode<E>(data_.data() + offsets_[i] + header.position(),
+                                         std::span{words}.first(num_words));
+         if (delta_codec::block_size == n) {
+            delta_codec::unpackers[width](words.data(), first, reference, ids.data());
+         }
+         else {
+            std::array<std::uint64_t, delta_codec::block_size> block;
+            delta_codec::unpackers[width](words.data(), first, reference, block.data());
+            std::copy_n(block.begin(), n, ids.begin());
+         }
+         return n;
+      }
+
+   private:
+      std::size_t size_ = 0;
+      std::vector<std::uint64_t> offsets_;
+      std::span<std::byte const> data_;
+   };
+
+   template<std::endian E>
+   std::size_t delta_codec::decode(read_buffer<E> &reader, std::span<std::uint64_t> const ids) {
+      delta_block_view<E> const view{reader};
+      if (ids.size() < view.size()) {
+         throw std::out_of_range{"Cannot read IDs, not enough space for the decoded IDs"};
+      }
+      for (std::size_t i = 0; i < view.num_blocks(); ++i) {
+         view.block(i, ids.subspan(i * block_size));
+      }
+      return view.size();
+   }
+} // io::skizzay::identigen
@@ -0,0 +1,408 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/timestamp_provider.h"
+#include "io/skizzay/identigen/value_provider.h"
+#include "io/skizzay/identigen/key.h"
+#include "io/skizzay/identigen/id_layout.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace io::skizzay::identigen {
+   struct clock_regression : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   // What a generator does when it cannot take a slot at the current tick, either because the clock has moved
+   // backwards or because the sequence for the current tick is exhausted. The generator may issue IDs up to max_borrow
+   // ahead of the clock; beyond that it spins until the clock catches up, which takes at most max_stall. If the clock
+   // is further behind than max_borrow + max_stall, generation throws clock_regression instead of stalling.
+   struct clock_regression_policy final {
+      std::chrono::nanoseconds max_borrow = std::chrono::nanoseconds::zero();
+      std::chrono::nanoseconds max_stall = std::chrono::nanoseconds::max();
+
+      // Waits for the clock to catch up
+      static constexpr clock_regression_policy spin(
+         std::chrono::nanoseconds const max_stall = std::chrono::nanoseconds::max()) noexcept {
+         return {std::chrono::nanoseconds::zero(), max_stall};
+      }
+
+      // Carries on issuing IDs from future ticks, waiting only once the clock is more than max_borrow behind
+      static constexpr clock_regression_policy borrow(
+         std::chrono::nanoseconds const max_borrow,
+         std::chrono::nanoseconds const max_stall = std::chrono::nanoseconds::max()) noexcept {
+         return {max_borrow, max_stall};
+      }
+   };
+
+   // Packs the values of each provider, most significant first, followed by a per-timestamp sequence number into a
+   // single 64-bit ID laid out by Layout. The sequence is reset whenever the timestamp provider moves on to a new
+   // tick; if it is exhausted within a tick (or the clock moves backwards), the clock regression policy decides whether
+   // to borrow from future ticks or wait for the clock to catch up.
+   template<typename Layout, timestamp_provider TimestampProvider, value_provider... Providers>
+      requires (Layout::num_fields == sizeof...(Providers) + 1)
+   class basic_generator {
+   public:
+      using layout_type = Layout;
+      using timestamp_type = std::invoke_result_t<TimestampProvider &>;
+      using duration = typename timestamp_type::duration;
+      using id_type = typename Layout::id_type;
+
+      basic_generator(Layout const layout, TimestampProvider timestamp_provider, Providers... providers)
+         : basic_generator{clock_regression_policy{}, layout, std::move(timestamp_provider), std::move(providers)...} {
+      }
+
+      basic_generator(clock_regression_policy const policy, Layout const layout, TimestampProvider timestamp_provider,
+                      Providers... providers)
+         : layout_{layout},
+           timestamp_provider_{std::move(timestamp_provider)},
+           providers_{std::move(providers)...},
+           max_borrow_{to_ticks(policy.max_borrow)},
+           max_stall_{to_ticks(policy.max_stall)},
+           origin_{timestamp_provider_()},
+           latest_tick_{0},
+           limit_tick_{std::numeric_limits<std::uint64_t>::max()},
+           forwarded_tick_{std::numeric_limits<std::int64_t>::min()},
+           forwarded_lead_{0},
+           state_{0} {
+         if (id_layout_utilities::max_significant_bits <= num_sequence_bits()) {
+            throw std::invalid_argument{"Cannot create generator, sequence leaves no bits for the tick"};
+         }
+         auto const widths = widths_of(std::index_sequence_for<Providers...>{});
+         for (std::size_t i = 0; i < widths.size(); ++i) {
+            if (layout_.width(i) < widths[i]) {
+               throw std::invalid_argument{"Cannot create generator, value provider does not fit its layout field"};
+            }
+         }
+      }
+
+      basic_generator(basic_generator const &) = delete;
+
+      basic_generator &operator=(basic_generator const &) = delete;
+
+      template<key K>
+         requires (value_provider_for<Providers, timestamp_type, K> && ...)
+      [[nodiscard]]
+      id_type next(K const &k) {
+         auto const reserved = reserve(1);
+         return compose(to_timestamp(reserved.tick), k, reserved.sequence, std::index_sequence_for<Providers...>{});
+      }
+
+      [[nodiscard]]
+      id_type next() {
+         return next(std::size_t{});
+      }
+
+      // Fills ids with IDs for k. Each run of sequence numbers is claimed with a single CAS and the providers are
+      // only consulted once per run, leaving a contiguous fill the compiler can vectorize.
+      template<key K>
+         requires (value_provider_for<Providers, timestamp_type, K> && ...)
+      void generate_n(std::span<id_type> const ids, K const &k) {
+         for (std::size_t filled = 0; filled < ids.size();) {
+            auto const reserved = reserve(ids.size() - filled);
+            fill(ids.subspan(filled, reserved.count), reserved, k);
+            filled += reserved.count;
+         }
+      }
+
+      // Fills ids with one ID for each of the corresponding keys, claiming each run of sequence numbers with a single
+      // CAS.
+      template<typename K>
+         requires key<std::remove_const_t<K> > && (
+                     value_provider_for<Providers, timestamp_type, std::remove_const_t<K> > && ...)
+      void generate_n(std::span<id_type> const ids, std::span<K> const keys) {
+         if (ids.size() != keys.size()) {
+            throw std::invalid_argument{"Cannot generate IDs, number of IDs and keys differ"};
+         }
+         for (std::size_t filled = 0; filled < ids.size();) {
+            auto const reserved = reserve(ids.size() - filled);
+            auto const ts = to_timestamp(reserved.tick);
+            for (std::size_t i = 0; i < reserved.count; ++i) {
+               ids[filled + i] = compose(ts, keys[filled + i], reserved.sequence + i,
+                                         std::index_sequence_for<Providers...>{});
+            }
+            filled += reserved.count;
+         }
+      }
+
+      // Like next, but returns nothing instead of waiting when the policy would have it wait for the clock
+      template<key K>
+         requires (value_provider_for<Providers, timestamp_type, K> && ...)
+      [[nodiscard]]
+      std::optional<id_type> try_next(K const &k) {
+         if (auto const reserved = try_reserve(1)) {
+            return compose(to_timestamp(reserved->tick), k, reserved->sequence,
+                           std::index_sequence_for<Providers...>{});
+         }
+         return std::nullopt;
+      }
+
+      // Like generate_n, but stops instead of waiting when the policy would have it wait for the clock. Returns the
+      // number of IDs filled in from the front of ids.
+      template<key K>
+         requires (value_provider_for<Providers, timestamp_type, K> && ...)
+      [[nodiscard]]
+      std::size_t try_generate_n(std::span<id_type> const ids, K const &k) {
+         std::size_t filled = 0;
+         while (filled < ids.size()) {
+            auto const reserved = try_reserve(ids.size() - filled);
+            if (!reserved) {
+               break;
+            }
+            fill(ids.subspan(filled, reserved->count), *reserved, k);
+            filled += reserved->count;
+         }
+         return filled;
+      }
+
+      [[nodiscard]]
+      Layout const &layout() const noexcept {
+         return layout_;
+      }
+
+      [[nodiscard]]
+      std::size_t num_sequence_bits() const noexcept {
+         return layout_.width(sizeof...(Providers));
+      }
+
+      [[nodiscard]]
+      std::size_t num_significant_bits() const noexcept {
+         return layout_.num_significant_bits();
+      }
+
+      // Timestamp the timestamp provider gives now
+      [[nodiscard]]
+      timestamp_type now() {
+         return timestamp_provider_();
+      }
+
+      // Timestamp of the latest tick any ID has been issued from, or of the origin if none has been issued yet
+      [[nodiscard]]
+      timestamp_type high_water_mark() const noexcept {
+         auto const slot = state_.load(std::memory_order_acquire);
+         auto const tick = to_full_tick(slot);
+         return to_timestamp(0 != (slot & sequence_mask()) || 0 == tick ? tick : tick - 1);
+      }
+
+      // Makes every later ID carry a timestamp after ts, e.g. the high-water mark of a previous run. If the clock has
+      // not passed ts, the generator borrows the ticks up to the one after it whatever its clock regression policy, so
+      // that it carries on at once instead of waiting for the clock: until the clock reaches that tick, IDs may run as
+      // far ahead of the clock as that tick was, and the policy only governs any lead beyond that.
+      void fast_forward(timestamp_type const ts) noexcept {
+         auto const tick = to_tick(ts);
+         if (tick < 0) {
+            return;
+         }
+         auto const floor = static_cast<std::uint64_t>(tick) + 1;
+         if (auto const now = to_tick(timestamp_provider_()); now <= tick) {
+            forwarded_lead_.store(floor - static_cast<std::uint64_t>(now), std::memory_order_relaxed);
+            forwarded_tick_.store(tick + 1, std::memory_order_relaxed);
+         }
+         auto slot = state_.load(std::memory_order_acquire);
+         while (to_full_tick(slot) < floor) {
+            raise_latest_tick(floor);
+            if (state_.compare_exchange_weak(slot, to_slot(floor, 0), std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+               break;
+            }
+         }
+      }
+
+      // Lets IDs be issued only from ticks before ts, or from any tick when there is none, e.g. to keep them within a
+      // high-water mark already on disk. Past the limit, generation waits as it does for the clock to catch up.
+      void issue_until(std::optional<timestamp_type> const ts) noexcept {
+         auto const tick = ts ? std::max(to_tick(*ts), std::int64_t{}) : std::numeric_limits<std::int64_t>::max();
+         limit_tick_.store(static_cast<std::uint64_t>(tick), std::memory_order_relaxed);
+      }
+
+   private:
+      // A run of sequence numbers claimed from a tick since the origin
+      struct reservation final {
+         std::uint64_t tick;
+         std::uint64_t sequence;
+         std::uint64_t count;
+      };
+
+      template<std::size_t... I>
+      std::array<std::size_t, sizeof...(Providers)> widths_of(std::index_sequence<I...>) const noexcept {
+         return {std::get<I>(providers_).num_significant_bits()...};
+      }
+
+      [[nodiscard]]
+      std::uint64_t sequence_mask() const noexcept {
+         return id_layout_utilities::low_mask(num_sequence_bits());
+      }
+
+      [[nodiscard]]
+      std::uint64_t tick_mask() const noexcept {
+         return id_layout_utilities::low_mask(id_layout_utilities::max_significant_bits - num_sequence_bits());
+      }
+
+      static std::uint64_t to_ticks(std::chrono::nanoseconds const bound) noexcept {
+         using ticks = std::chrono::duration<long double, typename duration::period>;
+         auto const result = std::chrono::duration_cast<ticks>(bound).count();
+         return result < 0 ? 0
+                : static_cast<long double>(std::numeric_limits<std::uint64_t>::max()) <= result
+                ? std::numeric_limits<std::uint64_t>::max()
+                : static_cast<std::uint64_t>(result);
+      }
+
+      // Ticks since the origin, which are negative when the clock has stepped back past it
+      [[nodiscard]]
+      std::int64_t to_tick(timestamp_type const ts) const noexcept {
+         return static_cast<std::int64_t>((ts - origin_).count());
+      }
+
+      [[nodiscard]]
+      timestamp_type to_timestamp(std::uint64_t const tick) const noexcept {
+         return origin_ + duration{static_cast<typename duration::rep>(tick)};
+      }
+
+      // A slot is the tick since the origin shifted above the sequence number, truncated to the bits the sequence
+      // leaves, so that a generator outlives 2^(64 - sequence bits) ticks
+      [[nodiscard]]
+      std::uint64_t to_slot(std::uint64_t const tick, std::uint64_t const sequence) const noexcept {
+         return ((tick & tick_mask()) << num_sequence_bits()) | sequence;
+      }
+
+      // Widens the truncated tick of a slot to the tick nearest the latest one, which the state never strays far from
+      [[nodiscard]]
+      std::uint64_t to_full_tick(std::uint64_t const slot) const noexcept {
+         auto const latest = latest_tick_.load(std::memory_order_relaxed);
+         auto const mask = tick_mask();
+         auto const delta = ((slot >> num_sequence_bits()) - latest) & mask;
+         return delta <= (mask >> 1) ? latest + delta : latest - (mask - delta) - 1;
+      }
+
+      // Raised before the state is moved to a tick, so that whoever sees the new state widens it from there
+      void raise_latest_tick(std::uint64_t const tick) noexcept {
+         auto latest = latest_tick_.load(std::memory_order_relaxed);
+         while (latest < tick && !latest_tick_.compare_exchange_weak(latest, tick, std::memory_order_relaxed)) {
+         }
+      }
+
+      // The state holds the next free slot, so a single CAS both claims a run of up to n sequence numbers and resets
+      // the sequence whenever the clock has moved on. Returns the run claimed, or nothing if the policy says to wait.
+      std::optional<reservation> try_reserve(std::uint64_t const n) {
+         auto const mask = sequence_mask();
+         auto slot = state_.load(std::memory_order_acquire);
+         for (;;) {
+            auto const now = to_tick(timestamp_provider_());
+            auto tick = to_full_tick(slot);
+            auto sequence = slot & mask;
+            if (auto const clamped = static_cast<std::uint64_t>(std::max(now, std::int64_t{})); tick < clamped) {
+               tick = clamped;
+               sequence = 0;
+            }
+            auto max_borrow = max_borrow_;
+            if (now < forwarded_tick_.load(std::memory_order_relaxed)) {
+               auto const forwarded = forwarded_lead_.load(std::memory_order_relaxed);
+               max_borrow = forwarded < std::numeric_limits<std::uint64_t>::max() - max_borrow
+                            ? max_borrow + forwarded
+                            : std::numeric_limits<std::uint64_t>::max();
+            }
+            if (auto const lead = tick - static_cast<std::uint64_t>(now); max_borrow < lead) {
+               if (max_stall_ < lead - max_borrow) {
+                  throw clock_regression{"Cannot generate ID, clock is further behind than the policy allows"};
+               }
+               return std::nullopt;
+            }
+            if (limit_tick_.load(std::memory_order_relaxed) <= tick) {
+               return std::nullopt;
+            }
+            auto const left = mask - sequence + 1;
+            auto const count = std::min(n, left);
+            auto const next_tick = count == left ? tick + 1 : tick;
+            raise_latest_tick(next_tick);
+            if (state_.compare_exchange_weak(slot, to_slot(next_tick, count == left ? 0 : sequence + count),
+                                             std::memory_order_acq_rel, std::memory_order_acquire)) {
+               return reservation{tick, sequence, count};
+            }
+         }
+      }
+
+      reservation reserve(std::uint64_t const n) {
+         for (;;) {
+            if (auto const reserved = try_reserve(n)) {
+               return *reserved;
+            }
+         }
+      }
+
+      // Fills run with consecutive sequence numbers starting from the reserved one
+      template<typename K>
+      void fill(std::span<id_type> const run, reservation const &reserved, K const &k) const {
+         auto const base = compose(to_timestamp(reserved.tick), k, 0, std::index_sequence_for<Providers...>{});
+         for (std::size_t i = 0; i < run.size(); ++i) {
+            run[i] = base | (reserved.sequence + i);
+         }
+      }
+
+      template<typename K, std::size_t... I>
+      [[nodiscard]]
+      id_type compose([[maybe_unused]] timestamp_type const ts, K const &k, std::uint64_t const sequence,
+                      std::index_sequence<I...>) const {
+         return layout_.pack({static_cast<id_type>(std::get<I>(providers_).value(ts, k))..., sequence});
+      }
+
+      Layout const layout_;
+      TimestampProvider timestamp_provider_;
+      std::tuple<Providers...> providers_;
+      std::uint64_t const max_borrow_;
+      std::uint64_t const max_stall_;
+      timestamp_type const origin_;
+      std::atomic<std::uint64_t> latest_tick_;
+      std::atomic<std::uint64_t> limit_tick_;
+      // The tick last fast-forwarded to while the clock was behind it, and how far behind the clock was
+      std::atomic<std::int64_t> forwarded_tick_;
+      std::atomic<std::uint64_t> forwarded_lead_;
+      std::atomic<std::uint64_t> state_;
+   };
+
+   // Generator whose layout is taken from the providers' significant bits at runtime.
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   class generator final
+         : public basic_generator<dynamic_id_layout<sizeof...(Providers) + 1>, TimestampProvider, Providers...> {
+      using base_type = basic_generator<dynamic_id_layout<sizeof...(Providers) + 1>, TimestampProvider, Providers...>;
+
+   public:
+      generator(TimestampProvider timestamp_provider, std::size_t const sequence_bits, Providers... providers)
+         : base_type{layout_for(sequence_bits, providers...), std::move(timestamp_provider), providers...} {
+      }
+
+      generator(clock_regression_policy const policy, TimestampProvider timestamp_provider,
+                std::size_t const sequence_bits, Providers... providers)
+         : base_type{policy, layout_for(sequence_bits, providers...), std::move(timestamp_provider), providers...} {
+      }
+
+   private:
+      static dynamic_id_layout<sizeof...(Providers) + 1> layout_for(std::size_t const sequence_bits,
+                                                                   Providers const &... providers) {
+         if (id_layout_utilities::max_significant_bits <= sequence_bits) {
+            throw std::invalid_argument{"Cannot create generator, ID layout exceeds 64 bits"};
+         }
+         return dynamic_id_layout<sizeof...(Providers) + 1>{{providers.num_significant_bits()..., sequence_bits}};
+      }
+   };
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   generator(TimestampProvider, std::size_t, Providers...) -> generator<TimestampProvider, Providers...>;
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   generator(clock_regression_policy, TimestampProvider, std::size_t, Providers...) -> generator<
+      TimestampProvider, Providers...>;
+} // io::skizzay::identigen
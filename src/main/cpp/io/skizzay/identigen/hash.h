@@ -0,0 +1,300 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/checksum.h"
+#include "io/skizzay/identigen/key.h"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   struct key_hash;
+
+   struct standard_hash;
+
+   // Hash a hashed_key is made with unless another is given: standard_hash, which partitioning providers use by
+   // default, for keys std::hash can hash, and key_hash for the rest
+   template<typename T>
+   using default_key_hash = std::conditional_t<key<T>, standard_hash, key_hash>;
+
+   template<typename T, typename Hash = default_key_hash<T> >
+      requires std::regular_invocable<Hash const &, T const &>
+   class hashed_key;
+
+   template<typename T>
+   struct is_hashed_key : std::false_type {
+   };
+
+   template<typename T, typename Hash>
+   struct is_hashed_key<hashed_key<T, Hash> > : std::true_type {
+   };
+
+   struct hash_utilities {
+      hash_utilities() = delete;
+
+      // Finalizer of MurmurHash3: a bijection in which every input bit affects every output bit
+      static constexpr std::uint64_t mix(std::uint64_t x) noexcept {
+         x ^= x >> 33;
+         x *= mix_multiplier_1;
+         x ^= x >> 33;
+         x *= mix_multiplier_2;
+         return x ^ (x >> 33);
+      }
+
+      // Hash of a composite of values with the given hashes, which depends on their order
+      static constexpr std::uint64_t combine(std::uint64_t const seed, std::uint64_t const hash) noexcept {
+         auto const product = static_cast<unsigned __int128>(seed ^ combine_key_1) * (hash ^ combine_key_2);
+         return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+      }
+
+      template<std::same_as<std::uint64_t>... H>
+      static constexpr std::uint64_t combine(std::uint64_t const seed, std::uint64_t const hash,
+                                             H const... hashes) noexcept {
+         return combine(combine(seed, hash), hashes...);
+      }
+
+      // XXH3 of the bytes
+      [[nodiscard]]
+      static std::uint64_t hash_bytes(std::span<std::byte const> const bytes) noexcept {
+         return xxh3::compute(bytes);
+      }
+
+      template<typename T>
+      static consteval bool is_hashable() {
+         if constexpr (is_hashed_key<T>::value || std::integral<T> || std::is_enum_v<T> || std::floating_point<T> ||
+                       std::convertible_to<T const &, std::string_view> || is_byte_range<T>()) {
+            return true;
+         }
+         else if constexpr (std::ranges::input_range<T const>) {
+            return is_hashable<std::remove_cvref_t<std::ranges::range_reference_t<T const> > >();
+         }
+         else if constexpr (is_tuple_like<T>) {
+            return []<std::size_t... I>(std::index_sequence<I...>) {
+               return (is_hashable<std::remove_cv_t<std::tuple_element_t<I, T> > >() && ...);
+            }(std::make_index_sequence<std::tuple_size_v<T> >{});
+         }
+         else {
+            return key<T>;
+         }
+      }
+
+      // Whether a value hashes as the bytes it is made of: contiguous ranges of values whose equality is that of their
+      // bytes. Strings, string views and spans of chars hash alike.
+      template<typename T>
+      static consteval bool is_byte_range() {
+         if constexpr (std::ranges::contiguous_range<T const> && std::ranges::sized_range<T const>) {
+            using value_t = std::remove_cv_t<std::ranges::range_value_t<T const> >;
+            return (std::integral<value_t> || std::is_enum_v<value_t>) && std::has_unique_object_representations_v<
+                      value_t>;
+         }
+         else {
+            return false;
+         }
+      }
+
+      // Writes the hash of each key to the front of hashes. With key_hash and AVX2, 64-bit integers are hashed four at
+      // a time. Throws std::out_of_range if there are more keys than hashes.
+      template<typename K, typename Hash = key_hash>
+         requires key<K, Hash>
+      static void hash(std::span<K const> keys, std::span<std::size_t> const hashes, Hash const &h = {}) {
+         if (hashes.size() < keys.size()) {
+            throw std::out_of_range{"Cannot hash keys, not enough space for the hashes"};
+         }
+         auto *out = hashes.data();
+#if defined(__AVX2__)
+         if constexpr (std::same_as<Hash, key_hash> && std::integral<K> && 8 == sizeof(K)) {
+            for (; 4 <= keys.size(); keys = keys.subspan(4), out += 4) {
+               _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                                   mix(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(keys.data()))));
+            }
+         }
+#endif
+         for (auto const &k: keys) {
+            *out++ = h(k);
+         }
+      }
+
+   private:
+      static constexpr std::uint64_t mix_multiplier_1 = 0xff51afd7ed558ccd;
+      static constexpr std::uint64_t mix_multiplier_2 = 0xc4ceb9fe1a85ec53;
+      static constexpr std::uint64_t combine_key_1 = 0xa0761d6478bd642f;
+      static constexpr std::uint64_t combine_key_2 = 0xe7037ed1a0b428db;
+
+      template<typename T>
+      static constexpr bool is_tuple_like = requires { std::tuple_size<T>::value; };
+
+#if defined(__AVX2__)
+      // Low 64 bits of each lane's product, from three 32-bit multiplies as AVX2 has no 64-bit one
+      static __m256i multiply(__m256i const x, std::uint64_t const multiplier) noexcept {
+         auto const low = _mm256_set1_epi64x(static_cast<long long>(multiplier & 0xffffffff));
+         auto const high = _mm256_set1_epi64x(static_cast<long long>(multiplier >> 32));
+         auto const cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), low),
+                                             _mm256_mul_epu32(x, high));
+         return _mm256_add_epi64(_mm256_mul_epu32(x, low), _mm256_slli_epi64(cross, 32));
+      }
+
+      static __m256i mix(__m256i x) noexcept {
+         x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+         x = multiply(x, mix_multiplier_1);
+         x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+         x = multiply(x, mix_multiplier_2);
+         return _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+      }
+#endif
+   };
+
+   // Hash of keys for partitioning, evenly spread where std::hash is not: integers, enums and floating point values
+   // are mixed rather than returned as they are, strings and other contiguous ranges of integers are hashed as their
+   // bytes with XXH3, and pairs, tuples and other ranges combine the hashes of their elements. Other types fall back
+   // to mixing their std::hash. Integers of equal value hash alike whatever their type.
+   struct key_hash final {
+      template<typename T>
+         requires (hash_utilities::is_hashable<T>())
+      [[nodiscard]]
+      std::size_t operator()(T const &x) const noexcept {
+         if constexpr (is_hashed_key<T>::value) {
+            if constexpr (std::same_as<typename T::hasher, key_hash>) {
+               return x.hash();
+            }
+            else {
+               return (*this)(x.get());
+            }
+         }
+         else if constexpr (std::integral<T>) {
+            return hash_utilities::mix(static_cast<std::uint64_t>(x));
+         }
+         else if constexpr (std::is_enum_v<T>) {
+            return (*this)(std::to_underlying(x));
+         }
+         else if constexpr (std::floating_point<T>) {
+            // -0.0 == 0.0, so both hash as 0.0
+            return (*this)(std::bit_cast<std::uint64_t>(static_cast<double>(x) + 0.0));
+         }
+         else if constexpr (std::convertible_to<T const &, std::string_view>) {
+            auto const s = static_cast<std::string_view>(x);
+            return hash_utilities::hash_bytes(std::as_bytes(std::span{s}));
+         }
+         else if constexpr (hash_utilities::is_byte_range<T>()) {
+            return hash_utilities::hash_bytes(std::as_bytes(std::span{std::ranges::data(x), std::ranges::size(x)}));
+         }
+         else if constexpr (std::ranges::input_range<T const>) {
+            std::uint64_t result = 0;
+            std::uint64_t n = 0;
+            for (auto const &element: x) {
+               result = hash_utilities::combine(result, (*this)(element));
+               ++n;
+            }
+            return hash_utilities::combine(result, n);
+         }
+         else if constexpr (requires { std::tuple_size<T>::value; }) {
+            return [&x, this]<std::size_t... I>(std::index_sequence<I...>) {
+               std::uint64_t result = std::tuple_size_v<T>;
+               ((result = hash_utilities::combine(result, (*this)(std::get<I>(x)))), ...);
+               return result;
+            }(std::make_index_sequence<std::tuple_size_v<T> >{});
+         }
+         else {
+            return hash_utilities::mix(std::hash<T>{}(x));
+         }
+      }
+   };
+
+   // std::hash of whatever it is given: the hash keys are partitioned by unless another is chosen
+   struct standard_hash final {
+      template<key T>
+      [[nodiscard]]
+      std::size_t operator()(T const &x) const noexcept(noexcept(std::hash<T>{}(x))) {
+         return std::hash<T>{}(x);
+      }
+   };
+
+   // A key with its hash, computed once when it is made. Passing one to a generator hashes the key once per request
+   // rather than once for each provider: providers partitioning by the hash it was made with take the stored hash
+   // instead of hashing the key again. Under any other hash it hashes as the bare key would, so it lands in the same
+   // partition as the bare key. Unless given another hash it is made with default_key_hash, which agrees with the
+   // partitioning providers' default, so that default usage hashes the key once.
+   //
+   // The key may be a view, so string and byte keys need not be copied into an owning type first: a string_view or
+   // C string key hashes as the std::string with the same characters under both hashes, and spans compare by their
+   // elements. A view must outlive the hashed_key.
+   template<typename T, typename Hash>
+      requires std::regular_invocable<Hash const &, T const &>
+   class hashed_key final {
+   public:
+      using key_type = T;
+      using hasher = Hash;
+
+      explicit hashed_key(T k, Hash const &h = {}) noexcept(std::is_nothrow_move_constructible_v<T> && noexcept(h(k)))
+         : key_{std::move(k)},
+           hash_{h(key_)} {
+      }
+
+      [[nodiscard]]
+      T const &get() const noexcept {
+         return key_;
+      }
+
+      [[nodiscard]]
+      std::size_t hash() const noexcept {
+         return hash_;
+      }
+
+      friend bool operator==(hashed_key const &lhs, hashed_key const &rhs) {
+         if (lhs.hash_ != rhs.hash_) {
+            return false;
+         }
+         if constexpr (std::equality_comparable<T>) {
+            return lhs.key_ == rhs.key_;
+         }
+         else {
+            return std::ranges::equal(lhs.key_, rhs.key_);
+         }
+      }
+
+      friend auto operator<=>(hashed_key const &lhs, hashed_key const &rhs)
+         requires std::three_way_comparable<T> {
+         return lhs.key_ <=> rhs.key_;
+      }
+
+   private:
+      T key_;
+      std::size_t hash_;
+   };
+
+   hashed_key(char const *) -> hashed_key<std::string_view>;
+
+   template<typename Hash>
+   hashed_key(char const *, Hash const &) -> hashed_key<std::string_view, Hash>;
+} // io::skizzay::identigen
+
+// The stored hash when it was made by std::hash, otherwise std::hash of the key, for keys that have one
+template<typename T, typename Hash>
+struct std::hash<io::skizzay::identigen::hashed_key<T, Hash> > {
+   std::size_t operator()(io::skizzay::identigen::hashed_key<T, Hash> const &k) const noexcept {
+      if constexpr (std::same_as<Hash, std::hash<T> > || std::same_as<Hash, io::skizzay::identigen::standard_hash> ||
+                    !io::skizzay::identigen::key<T>) {
+         return k.hash();
+      }
+      else {
+         return std::hash<T>{}(k.get());
+      }
+   }
+};
@@ -4,11 +4,14 @@
 
 #pragma once
 
-#include <functional>
+#include "io/skizzay/identigen/hash.h"
+
+#include <concepts>
+#include <cstddef>
 
 namespace io::skizzay::identigen {
    constexpr std::size_t hash_combine(std::size_t const seed, std::size_t const value) noexcept {
-      return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+      return hash_utilities::combine(seed, value);
    }
 
    template<std::same_as<std::size_t>... H>
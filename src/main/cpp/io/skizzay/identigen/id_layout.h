@@ -0,0 +1,249 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   struct id_layout_utilities {
+      using id_type = std::uint64_t;
+
+      id_layout_utilities() = delete;
+
+      static constexpr std::size_t max_significant_bits = std::numeric_limits<id_type>::digits;
+
+      static constexpr id_type low_mask(std::size_t const bits) noexcept {
+         return max_significant_bits <= bits ? ~id_type{} : (id_type{1} << bits) - 1;
+      }
+
+      // Scatters the low bits of x into the set bits of mask (PDEP when BMI2 is available)
+      static constexpr id_type deposit(id_type const x, id_type const mask) noexcept {
+#if defined(__BMI2__)
+         if !consteval {
+            return _pdep_u64(x, mask);
+         }
+#endif
+         return 0 == mask ? 0 : (x << std::countr_zero(mask)) & mask;
+      }
+
+      // Gathers the set bits of mask from x into the low bits of the result (PEXT when BMI2 is available)
+      static constexpr id_type extract(id_type const x, id_type const mask) noexcept {
+#if defined(__BMI2__)
+         if !consteval {
+            return _pext_u64(x, mask);
+         }
+#endif
+         return 0 == mask ? 0 : (x & mask) >> std::countr_zero(mask);
+      }
+
+      template<std::size_t N>
+      static constexpr std::array<std::size_t, N> calculate_shifts(std::array<std::size_t, N> const &widths) noexcept {
+         std::array<std::size_t, N> result = {};
+         std::size_t shift = 0;
+         for (std::size_t i = N; 0 < i--;) {
+            result[i] = shift;
+            shift += widths[i];
+         }
+         return result;
+      }
+
+      template<std::size_t N>
+      static constexpr std::array<id_type, N> calculate_masks(std::array<std::size_t, N> const &widths) noexcept {
+         auto const shifts = calculate_shifts(widths);
+         std::array<id_type, N> result = {};
+         for (std::size_t i = 0; i < N; ++i) {
+            result[i] = max_significant_bits <= shifts[i] ? 0 : low_mask(widths[i]) << shifts[i];
+         }
+         return result;
+      }
+   };
+
+   // Bit layout of an ID known at compile time, most significant field first. Every shift and mask is a constant, so
+   // packing and decoding compile down to straight-line, branch-free code.
+   template<std::size_t... Widths>
+   struct id_layout final {
+      static_assert(0 < sizeof...(Widths), "ID layout requires at least one field");
+      static_assert((Widths + ...) <= id_layout_utilities::max_significant_bits, "ID layout exceeds 64 bits");
+
+      using id_type = id_layout_utilities::id_type;
+
+      static constexpr std::size_t num_fields = sizeof...(Widths);
+
+      [[nodiscard]]
+      static constexpr std::size_t num_significant_bits() noexcept {
+         return (Widths + ...);
+      }
+
+      [[nodiscard]]
+      static constexpr std::size_t width(std::size_t const i) noexcept {
+         return widths_[i];
+      }
+
+      [[nodiscard]]
+      static constexpr std::size_t shift(std::size_t const i) noexcept {
+         return shifts_[i];
+      }
+
+      [[nodiscard]]
+      static constexpr id_type mask(std::size_t const i) noexcept {
+         return masks_[i];
+      }
+
+      [[nodiscard]]
+      static constexpr id_type pack(std::array<id_type, num_fields> const &fields) noexcept {
+         return [&fields]<std::size_t... I>(std::index_sequence<I...>) {
+            return (id_layout_utilities::deposit(fields[I], masks_[I]) | ...);
+         }(std::make_index_sequence<num_fields>{});
+      }
+
+      template<std::size_t I>
+         requires (I < num_fields)
+      [[nodiscard]]
+      static constexpr id_type decode(id_type const id) noexcept {
+         return id_layout_utilities::extract(id, masks_[I]);
+      }
+
+      // Bulk decode sticks to shift and mask, which vectorizes where PEXT cannot
+      template<std::size_t I>
+         requires (I < num_fields)
+      static void decode(std::span<id_type const> const ids, std::span<id_type> const fields) {
+         if (fields.size() < ids.size()) {
+            throw std::out_of_range{"Cannot decode IDs, not enough space for the decoded fields"};
+         }
+         constexpr auto field_shift = shifts_[I];
+         constexpr auto field_mask = id_layout_utilities::low_mask(widths_[I]);
+         // A zero-width field above all 64 bits is shifted by 64, which the shift cannot do
+         if constexpr (id_layout_utilities::max_significant_bits <= field_shift) {
+            std::fill_n(fields.begin(), ids.size(), id_type{});
+         }
+         else {
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+               fields[i] = (ids[i] >> field_shift) & field_mask;
+            }
+         }
+      }
+
+      [[nodiscard]]
+      static constexpr std::array<id_type, num_fields> unpack(id_type const id) noexcept {
+         return [id]<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<id_type, num_fields>{decode<I>(id)...};
+         }(std::make_index_sequence<num_fields>{});
+      }
+
+   private:
+      static constexpr std::array<std::size_t, num_fields> widths_ = {Widths...};
+      static constexpr std::array<std::size_t, num_fields> shifts_ = id_layout_utilities::calculate_shifts(widths_);
+      static constexpr std::array<id_type, num_fields> masks_ = id_layout_utilities::calculate_masks(widths_);
+   };
+
+   // Builds a layout from value_provider_utilities factories, e.g.
+   //    id_layout_for<12, [] { return value_provider_utilities::partitioned(1024); }>
+   // for a 10-bit partition followed by a 12-bit sequence.
+   template<std::size_t SequenceBits, auto... Factories>
+   using id_layout_for = id_layout<Factories().num_significant_bits()..., SequenceBits>;
+
+   // Bit layout of an ID whose field widths are only known at runtime, most significant field first.
+   template<std::size_t N>
+   struct dynamic_id_layout final {
+      static_assert(0 < N, "ID layout requires at least one field");
+
+      using id_type = id_layout_utilities::id_type;
+
+      static constexpr std::size_t num_fields = N;
+
+      explicit constexpr dynamic_id_layout(std::array<std::size_t, N> const &widths)
+         : widths_{widths},
+           shifts_{id_layout_utilities::calculate_shifts(widths)},
+           masks_{id_layout_utilities::calculate_masks(widths)} {
+         std::size_t total = 0;
+         for (auto const w: widths_) {
+            if (id_layout_utilities::max_significant_bits < w) {
+               throw std::invalid_argument{"Cannot create ID layout, field exceeds 64 bits"};
+            }
+            total += w;
+         }
+         if (id_layout_utilities::max_significant_bits < total) {
+            throw std::invalid_argument{"Cannot create ID layout, layout exceeds 64 bits"};
+         }
+      }
+
+      [[nodiscard]]
+      constexpr std::size_t num_significant_bits() const noexcept {
+         return shifts_.front() + widths_.front();
+      }
+
+      [[nodiscard]]
+      constexpr std::size_t width(std::size_t const i) const noexcept {
+         return widths_[i];
+      }
+
+      [[nodiscard]]
+      constexpr std::size_t shift(std::size_t const i) const noexcept {
+         return shifts_[i];
+      }
+
+      [[nodiscard]]
+      constexpr id_type mask(std::size_t const i) const noexcept {
+         return masks_[i];
+      }
+
+      [[nodiscard]]
+      constexpr id_type pack(std::array<id_type, num_fields> const &fields) const noexcept {
+         id_type result = 0;
+         for (std::size_t i = 0; i < N; ++i) {
+            result |= id_layout_utilities::deposit(fields[i], masks_[i]);
+         }
+         return result;
+      }
+
+      template<std::size_t I>
+         requires (I < num_fields)
+      [[nodiscard]]
+      constexpr id_type decode(id_type const id) const noexcept {
+         return id_layout_utilities::extract(id, masks_[I]);
+      }
+
+      template<std::size_t I>
+         requires (I < num_fields)
+      void decode(std::span<id_type const> const ids, std::span<id_type> const fields) const {
+         if (fields.size() < ids.size()) {
+            throw std::out_of_range{"Cannot decode IDs, not enough space for the decoded fields"};
+         }
+         auto const field_shift = shifts_[I];
+         auto const field_mask = id_layout_utilities::low_mask(widths_[I]);
+         if (id_layout_utilities::max_significant_bits <= field_shift) {
+            std::fill_n(fields.begin(), ids.size(), id_type{});
+            return;
+         }
+         for (std::size_t i = 0; i < ids.size(); ++i) {
+            fields[i] = (ids[i] >> field_shift) & field_mask;
+         }
+      }
+
+      [[nodiscard]]
+      constexpr std::array<id_type, num_fields> unpack(id_type const id) const noexcept {
+         std::array<id_type, num_fields> result = {};
+         for (std::size_t i = 0; i < N; ++i) {
+            result[i] = id_layout_utilities::extract(id, masks_[i]);
+         }
+         return result;
+      }
+
+   private:
+      std::array<std::size_t, N> widths_;
+      std::array<std::size_t, N> shifts_;
+      std::array<id_type, N> masks_;
+   };
+} // io::skizzay::identigen
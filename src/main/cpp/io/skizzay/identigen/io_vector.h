@@ -0,0 +1,116 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+#include "io/skizzay/identigen/chained_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <system_error>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace io::skizzay::identigen {
+   // Gathers the output of any number of write buffers, chained buffers and sub-writers into one list of iovecs, so
+   // that it reaches a file or pipe with a single writev instead of being copied into a staging area first. The
+   // iovecs point into the buffers, which must outlive the write.
+   class io_vector final {
+   public:
+      io_vector &append(std::span<std::byte const> const bytes) {
+         if (!bytes.empty()) {
+            iovecs_.push_back({const_cast<std::byte *>(bytes.data()), bytes.size()});
+            size_ += bytes.size();
+         }
+         return *this;
+      }
+
+      template<std::endian E>
+      io_vector &append(write_buffer<E> const &writer) {
+         return append(writer.to_input_buffer());
+      }
+
+      template<std::endian E>
+      io_vector &append(chained_write_buffer<E> const &writer) {
+         for (auto const bytes: writer.to_input_buffers()) {
+            append(bytes);
+         }
+         return *this;
+      }
+
+      // Total number of bytes
+      [[nodiscard]]
+      std::size_t size_bytes() const noexcept {
+         return size_;
+      }
+
+      [[nodiscard]]
+      std::span<::iovec const> iovecs() const noexcept {
+         return iovecs_;
+      }
+
+      void clear() noexcept {
+         iovecs_.clear();
+         size_ = 0;
+      }
+
+   private:
+      std::vector<::iovec> iovecs_;
+      std::size_t size_ = 0;
+   };
+
+   struct io_vector_utilities {
+      io_vector_utilities() = delete;
+
+      // Writes all of bytes to fd with as few writev calls as IOV_MAX and short writes allow, retrying on EINTR.
+      // Returns the number of bytes written, which is bytes.size_bytes() unless it throws std::system_error.
+      static std::size_t write(int const fd, io_vector const &bytes) {
+         return write_all(bytes, [fd](::iovec const *const iov, int const count, std::size_t) {
+            return ::writev(fd, iov, count);
+         });
+      }
+
+      // As write, but at offset in fd with pwritev, leaving the file offset alone
+      static std::size_t write(int const fd, ::off_t const offset, io_vector const &bytes) {
+         return write_all(bytes, [fd, offset](::iovec const *const iov, int const count, std::size_t const written) {
+            return ::pwritev(fd, iov, count, offset + static_cast<::off_t>(written));
+         });
+      }
+
+   private:
+      template<typename Write>
+      static std::size_t write_all(io_vector const &bytes, Write const &write) {
+         // Copied only so that a short write can trim the first iovec in place
+         std::vector<::iovec> pending{bytes.iovecs().begin(), bytes.iovecs().end()};
+         std::size_t written = 0;
+         std::size_t first = 0;
+         while (first < pending.size()) {
+            auto const count = static_cast<int>(std::min<std::size_t>(pending.size() - first, IOV_MAX));
+            auto const result = write(pending.data() + first, count, written);
+            if (result < 0) {
+               if (EINTR == errno) {
+                  continue;
+               }
+               throw std::system_error{errno, std::generic_category(), "Cannot write buffers"};
+            }
+            auto remaining = static_cast<std::size_t>(result);
+            written += remaining;
+            while (first < pending.size() && pending[first].iov_len <= remaining) {
+               remaining -= pending[first].iov_len;
+               ++first;
+            }
+            if (0 < remaining) {
+               pending[first].iov_base = static_cast<std::byte *>(pending[first].iov_base) + remaining;
+               pending[first].iov_len -= remaining;
+            }
+         }
+         return written;
+      }
+   };
+} // io::skizzay::identigen
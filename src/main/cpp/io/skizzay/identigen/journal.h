@@ -0,0 +1,205 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace io::skizzay::identigen {
+   // Memory-mapped journal of a generator's high-water mark, so a restarted generator can fast-forward past every ID
+   // the previous run may have issued instead of waiting out the timestamp range. Marks are nanoseconds since the
+   // clock's epoch in host byte order, written alternately to two checksummed entries, so a torn write only ever loses
+   // the newest mark. Recording is a handful of stores into the page cache; only sync() reaches the disk.
+   class high_water_mark_journal final {
+   public:
+      explicit high_water_mark_journal(std::filesystem::path const &path)
+         : fd_{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)} {
+         if (fd_ < 0) {
+            throw std::system_error{errno, std::generic_category(), "Cannot open high-water mark journal"};
+         }
+         if (0 != ::ftruncate(fd_, file_size)) {
+            auto const error = errno;
+            ::close(fd_);
+            throw std::system_error{error, std::generic_category(), "Cannot size high-water mark journal"};
+         }
+         auto *const mapping = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+         if (MAP_FAILED == mapping) {
+            auto const error = errno;
+            ::close(fd_);
+            throw std::system_error{error, std::generic_category(), "Cannot map high-water mark journal"};
+         }
+         entries_ = static_cast<entry *>(mapping);
+         recover();
+      }
+
+      high_water_mark_journal(high_water_mark_journal const &) = delete;
+
+      high_water_mark_journal &operator=(high_water_mark_journal const &) = delete;
+
+      ~high_water_mark_journal() {
+         ::munmap(entries_, file_size);
+         ::close(fd_);
+      }
+
+      // Mark found when the journal was opened, if any
+      [[nodiscard]]
+      std::optional<std::chrono::nanoseconds> recovered() const noexcept {
+         return recovered_;
+      }
+
+      void record(std::chrono::nanoseconds const mark) noexcept {
+         auto const version = ++version_;
+         auto &r = entries_[version % num_entries];
+         std::atomic_ref{r.check}.store(0, std::memory_order_relaxed);
+         std::atomic_ref{r.version}.store(version, std::memory_order_relaxed);
+         std::atomic_ref{r.mark}.store(mark.count(), std::memory_order_relaxed);
+         std::atomic_ref{r.check}.store(checksum(version, mark.count()), std::memory_order_release);
+      }
+
+      // Flushes recorded marks to disk
+      void sync() const {
+         if (0 != ::msync(entries_, file_size, MS_SYNC)) {
+            throw std::system_error{errno, std::generic_category(), "Cannot sync high-water mark journal"};
+         }
+      }
+
+      // Fast-forwards the generator past the recovered mark, if any. The mark runs a lease ahead of the IDs the previous
+      // run issued, so the generator borrows up to it rather than waiting for its clock to get there.
+      template<typename Generator>
+      void restore(Generator &generator) const {
+         if (recovered_) {
+            using timestamp_type = typename Generator::timestamp_type;
+            generator.fast_forward(std::chrono::floor<typename timestamp_type::duration>(
+               std::chrono::time_point<typename timestamp_type::clock, std::chrono::nanoseconds>{*recovered_}));
+         }
+      }
+
+   private:
+      static constexpr std::uint64_t magic = 0x6964656e74696765; // "identige"
+      static constexpr std::size_t num_entries = 2;
+      static constexpr std::size_t file_size = 4096;
+
+      struct entry final {
+         std::uint64_t version;
+         std::int64_t mark;
+         std::uint64_t check;
+      };
+
+      static constexpr std::uint64_t checksum(std::uint64_t const version, std::int64_t const mark) noexcept {
+         auto x = magic ^ version ^ (static_cast<std::uint64_t>(mark) * 0x9e3779b97f4a7c15);
+         x ^= x >> 33;
+         x *= 0xff51afd7ed558ccd;
+         x ^= x >> 33;
+         return x | 1;
+      }
+
+      void recover() noexcept {
+         for (std::size_t i = 0; i < num_entries; ++i) {
+            auto const &r = entries_[i];
+            if (checksum(r.version, r.mark) == r.check && version_ <= r.version) {
+               version_ = r.version;
+               recovered_ = std::chrono::nanoseconds{r.mark};
+            }
+         }
+      }
+
+      int fd_;
+      entry *entries_ = nullptr;
+      std::uint64_t version_ = 0;
+      std::optional<std::chrono::nanoseconds> recovered_;
+   };
+
+   // Periodically journals a lease past the later of a generator's high-water mark and its clock from a background
+   // thread. Once a mark is on disk, the generator may issue IDs up to it and no further, so every ID issued before a
+   // crash is covered by a mark already on disk. Generation waits at the mark if the generator moves further than the
+   // lease between two checkpoints; a lease longer than the interval plus the sync time keeps that from happening while
+   // the clock runs normally. A checkpoint that fails in the background leaves the limit where it was, so generation
+   // holds at the last mark on disk until a later checkpoint succeeds; rethrow_failure() reports the error meanwhile.
+   // The generator is let go of its limit when the checkpointer is destroyed.
+   template<typename Generator>
+   class journal_checkpointer final {
+   public:
+      journal_checkpointer(high_water_mark_journal &journal, Generator &generator,
+                           std::chrono::nanoseconds const interval, std::chrono::nanoseconds const lease)
+         : journal_{journal},
+           generator_{generator},
+           lease_{lease} {
+         if (lease <= std::chrono::nanoseconds::zero()) {
+            throw std::invalid_argument{"Cannot create journal checkpointer, lease must be positive"};
+         }
+         checkpoint();
+         checkpointer_ = std::jthread{[this, interval](std::stop_token const token) {
+            std::mutex mutex;
+            std::unique_lock lock{mutex};
+            // Waits out the interval unless the checkpointer is being destroyed
+            while (!wakeup_.wait_for(lock, token, interval, [&token] { return token.stop_requested(); })) {
+               std::exception_ptr failure;
+               try {
+                  checkpoint();
+               }
+               catch (...) {
+                  failure = std::current_exception();
+               }
+               std::scoped_lock const guard{failure_mutex_};
+               failure_ = std::move(failure);
+            }
+         }};
+      }
+
+      journal_checkpointer(journal_checkpointer const &) = delete;
+
+      journal_checkpointer &operator=(journal_checkpointer const &) = delete;
+
+      ~journal_checkpointer() {
+         checkpointer_.request_stop();
+         checkpointer_.join();
+         generator_.issue_until(std::nullopt);
+      }
+
+      void checkpoint() {
+         using timestamp_type = typename Generator::timestamp_type;
+         auto const mark = std::max(generator_.high_water_mark(), generator_.now()) +
+                           std::chrono::floor<typename timestamp_type::duration>(lease_);
+         journal_.record(mark.time_since_epoch());
+         journal_.sync();
+         generator_.issue_until(mark);
+      }
+
+      // Rethrows the error of the latest background checkpoint, if it failed
+      void rethrow_failure() const {
+         std::scoped_lock const guard{failure_mutex_};
+         if (failure_) {
+            std::rethrow_exception(failure_);
+         }
+      }
+
+   private:
+      high_water_mark_journal &journal_;
+      Generator &generator_;
+      std::chrono::nanoseconds const lease_;
+      std::condition_variable_any wakeup_;
+      mutable std::mutex failure_mutex_;
+      std::exception_ptr failure_;
+      std::jthread checkpointer_;
+   };
+} // io::skizzay::identigen
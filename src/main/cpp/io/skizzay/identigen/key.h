@@ -8,11 +8,12 @@
 #include <functional>
 
 namespace io::skizzay::identigen {
-   template<typename T>
-   concept key = std::equality_comparable<T> && requires(T t, std::hash<T> h) {
+   // Values that can be compared and hashed with Hash, std::hash unless another is given
+   template<typename T, typename Hash = std::hash<T> >
+   concept key = std::equality_comparable<T> && requires(T t, Hash h) {
       { h(t) } -> std::same_as<std::size_t>;
    };
 
-   template<typename T>
-   concept sortable_key = key<T> && std::totally_ordered<T>;
+   template<typename T, typename Hash = std::hash<T> >
+   concept sortable_key = key<T, Hash> && std::totally_ordered<T>;
 }
@@ -0,0 +1,202 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace io::skizzay::identigen {
+   // Compile-time layout of fixed-size records: integers, floats, doubles and enums, and the tuple-like types (std::tuple,
+   // std::pair, std::array) and aggregates built from them. A record is written as its scalar fields in declaration
+   // order with no padding or length prefixes, so its encoded size is known at compile time and a whole record needs
+   // one bounds check. Aggregates are taken apart with structured bindings, which limits them to max_fields direct
+   // members, none of them C arrays or bases; use std::array for repeated fields.
+   struct record_utilities {
+      record_utilities() = delete;
+
+      static constexpr std::size_t max_fields = 16;
+
+      template<typename T>
+      static constexpr bool is_scalar = std::integral<T> || std::same_as<T, float> || std::same_as<T, double> ||
+                                        std::is_enum_v<T>;
+
+      // Type a scalar field is encoded as
+      template<typename T>
+      using encoded_type = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>,
+                                                       std::type_identity<T> >::type;
+
+      // Whether T is a record, and so can be written with write_buffer::put_record
+      template<typename T>
+      static consteval bool is_record() {
+         if constexpr (is_scalar<T>) {
+            return true;
+         }
+         else if constexpr (is_tuple_like<T>) {
+            return []<std::size_t... I>(std::index_sequence<I...>) {
+               return (is_record<std::remove_cv_t<std::tuple_element_t<I, T> > >() && ...);
+            }(std::make_index_sequence<std::tuple_size_v<T> >{});
+         }
+         else if constexpr (is_bindable_aggregate<T>()) {
+            return []<typename... F>(std::type_identity<std::tuple<F &...> >) {
+               return (is_record<std::remove_cv_t<F> >() && ...);
+            }(std::type_identity<decltype(tie(std::declval<T &>()))>{});
+         }
+         else {
+            return false;
+         }
+      }
+
+      // Number of bytes T takes once encoded
+      template<typename T>
+      static consteval std::size_t size() {
+         if constexpr (is_scalar<T>) {
+            return sizeof(encoded_type<T>);
+         }
+         else if constexpr (is_tuple_like<T>) {
+            return []<std::size_t... I>(std::index_sequence<I...>) {
+               return (std::size_t{} + ... + size<std::remove_cv_t<std::tuple_element_t<I, T> > >());
+            }(std::make_index_sequence<std::tuple_size_v<T> >{});
+         }
+         else {
+            return []<typename... F>(std::type_identity<std::tuple<F &...> >) {
+               return (std::size_t{} + ... + size<std::remove_cv_t<F> >());
+            }(std::type_identity<decltype(tie(std::declval<T &>()))>{});
+         }
+      }
+
+      // Calls f with every scalar field of x, depth first in declaration order
+      template<typename T, typename F>
+      static constexpr void for_each_field(T &x, F &&f) {
+         using record_type = std::remove_cv_t<T>;
+         if constexpr (is_scalar<record_type>) {
+            f(x);
+         }
+         else if constexpr (is_tuple_like<record_type>) {
+            [&x, &f]<std::size_t... I>(std::index_sequence<I...>) {
+               using std::get;
+               (for_each_field(get<I>(x), f), ...);
+            }(std::make_index_sequence<std::tuple_size_v<record_type> >{});
+         }
+         else {
+            auto const fields = tie(x);
+            [&fields, &f]<std::size_t... I>(std::index_sequence<I...>) {
+               (for_each_field(std::get<I>(fields), f), ...);
+            }(std::make_index_sequence<num_fields<record_type>()>{});
+         }
+      }
+
+   private:
+      template<typename T>
+      static constexpr bool is_tuple_like = requires { std::tuple_size<T>::value; };
+
+      // Converts to anything, to count the initializers an aggregate accepts
+      struct any_field final {
+         template<typename T>
+         constexpr operator T() const noexcept;
+      };
+
+      template<typename T, std::size_t N>
+      static consteval bool is_constructible_from() {
+         return []<std::size_t... I>(std::index_sequence<I...>) {
+            return requires { T{(static_cast<void>(I), any_field{})...}; };
+         }(std::make_index_sequence<N>{});
+      }
+
+      template<typename T, std::size_t N = max_fields>
+      static consteval std::size_t num_fields() {
+         if constexpr (0 == N || is_constructible_from<T, N>()) {
+            return N;
+         }
+         else {
+            return num_fields<T, N - 1>();
+         }
+      }
+
+      template<typename T>
+      static consteval bool is_bindable_aggregate() {
+         if constexpr (std::is_aggregate_v<T> && !std::is_array_v<T>) {
+            return 0 < num_fields<T>() && !is_constructible_from<T, max_fields + 1>();
+         }
+         else {
+            return false;
+         }
+      }
+
+      // References to the direct members of an aggregate
+      template<typename T>
+      static constexpr auto tie(T &x) noexcept {
+         if constexpr (1 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0] = x;
+            return std::tie(f0);
+         }
+         else if constexpr (2 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1] = x;
+            return std::tie(f0, f1);
+         }
+         else if constexpr (3 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2] = x;
+            return std::tie(f0, f1, f2);
+         }
+         else if constexpr (4 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3] = x;
+            return std::tie(f0, f1, f2, f3);
+         }
+         else if constexpr (5 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4] = x;
+            return std::tie(f0, f1, f2, f3, f4);
+         }
+         else if constexpr (6 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5);
+         }
+         else if constexpr (7 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6);
+         }
+         else if constexpr (8 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+         }
+         else if constexpr (9 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+         }
+         else if constexpr (10 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+         }
+         else if constexpr (11 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+         }
+         else if constexpr (12 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+         }
+         else if constexpr (13 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+         }
+         else if constexpr (14 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+         }
+         else if constexpr (15 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+         }
+         else if constexpr (16 == num_fields<std::remove_cv_t<T> >()) {
+            auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = x;
+            return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+         }
+      }
+   };
+
+   template<typename T>
+   concept fixed_size_record = record_utilities::is_record<T>();
+} // io::skizzay::identigen
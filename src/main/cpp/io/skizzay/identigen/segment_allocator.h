@@ -0,0 +1,235 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace io::skizzay::identigen {
+   // Hands out disjoint ranges of IDs: lease(n) returns the first ID of a range of n IDs that no other lease, from
+   // this or any other process, overlaps.
+   template<typename T>
+   concept segment_coordinator = requires(T t, std::uint64_t const n) {
+      { t.lease(n) } -> std::same_as<std::uint64_t>;
+   };
+
+   // Coordinator handing out consecutive ranges from an in-process counter, standing in for a remote one
+   class local_segment_coordinator final {
+   public:
+      explicit local_segment_coordinator(std::uint64_t const first = 0) noexcept
+         : next_{first} {
+      }
+
+      local_segment_coordinator(local_segment_coordinator const &) = delete;
+
+      local_segment_coordinator &operator=(local_segment_coordinator const &) = delete;
+
+      std::uint64_t lease(std::uint64_t const n) noexcept {
+         return next_.fetch_add(n, std::memory_order_relaxed);
+      }
+
+   private:
+      std::atomic<std::uint64_t> next_;
+   };
+
+   // Allocates IDs from segments leased from a coordinator, which gives uniqueness across nodes without a fixed worker
+   // field in the ID. Every caller takes a ticket from a single counter; ticket n is offset n % segment_size in
+   // segment n / segment_size, so the hot path is a fetch_add and a seqlock read. Once a segment is prefetch_threshold
+   // used, a background thread leases the next one, so callers only wait on the coordinator if it cannot keep up.
+   //
+   // A caller that stalls for longer than it takes to consume segments_in_flight segments finds its segment recycled
+   // and takes another ticket, so IDs may be skipped but are never issued twice. The coordinator is only ever called
+   // from the background thread. An exception it throws is rethrown to every caller waiting on that segment while the
+   // thread retries the lease, backing off from min_retry_delay up to max_retry_delay; once a lease succeeds, callers
+   // get IDs again.
+   template<segment_coordinator Coordinator>
+   class segment_allocator final {
+   public:
+      using id_type = std::uint64_t;
+
+      static constexpr std::size_t segments_in_flight = 4;
+      static constexpr std::chrono::milliseconds min_retry_delay{1};
+      static constexpr std::chrono::milliseconds max_retry_delay{1000};
+
+      segment_allocator(Coordinator coordinator, std::uint64_t const segment_size,
+                        double const prefetch_threshold = 0.5)
+         : coordinator_{std::move(coordinator)},
+           segment_size_{validate_segment_size(segment_size)},
+           prefetch_offset_{prefetch_offset_for(segment_size, prefetch_threshold)},
+           leaser_{[this](std::stop_token const token) { lease_segments(token); }} {
+      }
+
+      segment_allocator(segment_allocator const &) = delete;
+
+      segment_allocator &operator=(segment_allocator const &) = delete;
+
+      ~segment_allocator() {
+         leaser_.request_stop();
+         requested_.store(no_segment, std::memory_order_release);
+         requested_.notify_all();
+      }
+
+      [[nodiscard]]
+      id_type next() {
+         for (;;) {
+            auto const ticket = tickets_.fetch_add(1, std::memory_order_relaxed);
+            auto const segment = ticket / segment_size_;
+            auto const offset = ticket % segment_size_;
+            if (prefetch_offset_ == offset) {
+               request(segment + 1);
+            }
+            if (auto const base = await_segment(segment); no_segment != base) {
+               return base + offset;
+            }
+         }
+      }
+
+      [[nodiscard]]
+      std::uint64_t segment_size() const noexcept {
+         return segment_size_;
+      }
+
+   private:
+      static constexpr std::uint64_t no_segment = ~std::uint64_t{};
+
+      // generation holds the index of the segment in the slot plus one, or zero while it is empty or being written
+      struct slot final {
+         std::atomic<std::uint64_t> generation = 0;
+         std::atomic<std::uint64_t> base = 0;
+      };
+
+      static std::uint64_t validate_segment_size(std::uint64_t const segment_size) {
+         if (0 == segment_size) {
+            throw std::invalid_argument{"Cannot create segment allocator, segment size must be positive"};
+         }
+         return segment_size;
+      }
+
+      static std::uint64_t prefetch_offset_for(std::uint64_t const segment_size, double const prefetch_threshold) {
+         if (!(0.0 <= prefetch_threshold && prefetch_threshold <= 1.0)) {
+            throw std::invalid_argument{"Cannot create segment allocator, prefetch threshold must be within [0, 1]"};
+         }
+         auto const offset = static_cast<std::uint64_t>(static_cast<double>(segment_size) * prefetch_threshold);
+         return offset < segment_size ? offset : segment_size - 1;
+      }
+
+      void request(std::uint64_t const segment) noexcept {
+         auto requested = requested_.load(std::memory_order_relaxed);
+         while (requested < segment && !requested_.compare_exchange_weak(requested, segment,
+                                                                         std::memory_order_release)) {
+         }
+         requested_.notify_one();
+      }
+
+      // Returns the base of the segment, or no_segment if its slot has already been recycled
+      std::uint64_t await_segment(std::uint64_t const segment) {
+         auto &s = slots_[segment % segments_in_flight];
+         auto const ready = segment + 1;
+         for (;;) {
+            auto const published = published_.load(std::memory_order_acquire);
+            auto const generation = s.generation.load(std::memory_order_acquire);
+            if (ready < generation) {
+               return no_segment;
+            }
+            if (ready == generation) {
+               auto const base = s.base.load(std::memory_order_relaxed);
+               std::atomic_thread_fence(std::memory_order_acquire);
+               if (ready == s.generation.load(std::memory_order_relaxed)) {
+                  return base;
+               }
+               return no_segment;
+            }
+            if (failed_.load(std::memory_order_acquire)) {
+               rethrow_failure();
+            }
+            request(segment);
+            published_.wait(published, std::memory_order_acquire);
+         }
+      }
+
+      void rethrow_failure() const {
+         std::exception_ptr failure;
+         {
+            std::scoped_lock const guard{failure_mutex_};
+            failure = failure_;
+         }
+         if (failure) {
+            std::rethrow_exception(failure);
+         }
+      }
+
+      void lease_segments(std::stop_token const &token) {
+         std::uint64_t next_segment = 0;
+         auto retry_delay = min_retry_delay;
+         for (;;) {
+            auto const requested = requested_.load(std::memory_order_acquire);
+            if (token.stop_requested()) {
+               return;
+            }
+            if (requested < next_segment) {
+               requested_.wait(requested, std::memory_order_acquire);
+               continue;
+            }
+            try {
+               auto const base = coordinator_.lease(segment_size_);
+               failed_.store(false, std::memory_order_relaxed);
+               retry_delay = min_retry_delay;
+               publish(next_segment, base);
+               ++next_segment;
+            }
+            catch (...) {
+               {
+                  std::scoped_lock const guard{failure_mutex_};
+                  failure_ = std::current_exception();
+               }
+               failed_.store(true, std::memory_order_release);
+               published_.fetch_add(1, std::memory_order_release);
+               published_.notify_all();
+               std::mutex mutex;
+               std::unique_lock lock{mutex};
+               // Backs off before retrying unless the allocator is being destroyed
+               if (retry_.wait_for(lock, token, retry_delay, [&token] { return token.stop_requested(); })) {
+                  return;
+               }
+               retry_delay = std::min(retry_delay * 2, max_retry_delay);
+            }
+         }
+      }
+
+      void publish(std::uint64_t const segment, std::uint64_t const base) noexcept {
+         auto &s = slots_[segment % segments_in_flight];
+         s.generation.store(0, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_release);
+         s.base.store(base, std::memory_order_relaxed);
+         s.generation.store(segment + 1, std::memory_order_release);
+         published_.fetch_add(1, std::memory_order_release);
+         published_.notify_all();
+      }
+
+      Coordinator coordinator_;
+      std::uint64_t const segment_size_;
+      std::uint64_t const prefetch_offset_;
+      std::atomic<std::uint64_t> tickets_ = 0;
+      std::atomic<std::uint64_t> requested_ = 0;
+      std::atomic<std::uint64_t> published_ = 0;
+      std::atomic<bool> failed_ = false;
+      mutable std::mutex failure_mutex_;
+      std::exception_ptr failure_;
+      std::condition_variable_any retry_;
+      std::array<slot, segments_in_flight> slots_;
+      std::jthread leaser_;
+   };
+} // io::skizzay::identigen
@@ -0,0 +1,212 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+namespace io::skizzay::identigen {
+   template<typename T, std::endian E>
+   class sequence_view;
+
+   template<typename T, std::endian E>
+   struct is_sequence_view : std::false_type {
+   };
+
+   template<typename T, std::endian E>
+   struct is_sequence_view<sequence_view<T, E>, E> : std::true_type {
+   };
+
+   // What a sequence_view can hold: scalars, byte spans (ranges of bytes or chars written by put) and nested sequences
+   template<typename T, std::endian E>
+   concept sequence_element = buffer_scalar<T> || std::same_as<T, std::span<std::byte const> > ||
+                              is_sequence_view<T, E>::value;
+
+   // Lazy view over a range written by write_buffer<E>::put: the number of elements followed by the elements, which
+   // are decoded one at a time as the view is iterated. Byte ranges come out as spans into the buffer and nested
+   // ranges as nested views, so nothing is copied.
+   //
+   // Construction checks once that the whole sequence lies within the reader and moves the reader past it; skip()
+   // does the same without making a view. Neither decodes the elements: a sequence of scalars is stepped over in one
+   // go, and nested sequences only have their lengths read. The view refers to the reader's underlying bytes.
+   template<typename T, std::endian E>
+   class sequence_view final : public std::ranges::view_interface<sequence_view<T, E> > {
+      static_assert(sequence_element<T, E>, "Sequence elements must be scalars, byte spans or sequence views");
+
+   public:
+      using size_type = std::size_t;
+
+      class iterator final {
+      public:
+         using value_type = T;
+         using difference_type = std::ptrdiff_t;
+         using iterator_concept = std::forward_iterator_tag;
+
+         iterator() noexcept = default;
+
+         T operator*() const noexcept {
+            return decode(position_);
+         }
+
+         iterator &operator++() noexcept {
+            position_ += encoded_size(position_);
+            --remaining_;
+            return *this;
+         }
+
+         iterator operator++(int) noexcept {
+            auto result = *this;
+            ++*this;
+            return result;
+         }
+
+         friend bool operator==(iterator const &lhs, iterator const &rhs) noexcept {
+            return lhs.remaining_ == rhs.remaining_;
+         }
+
+      private:
+         friend class sequence_view;
+
+         iterator(std::byte const *const position, size_type const remaining) noexcept
+            : position_{position},
+              remaining_{remaining} {
+         }
+
+         std::byte const *position_ = nullptr;
+         size_type remaining_ = 0;
+      };
+
+      sequence_view() noexcept = default;
+
+      explicit sequence_view(read_buffer<E> &reader) {
+         auto const bytes = reader.available_bytes();
+         auto const n = value_or_throw(measure(bytes));
+         data_ = bytes.data() + sizeof(size_type);
+         size_ = load<size_type>(bytes.data());
+         reader.position(reader.position() + n);
+      }
+
+      // Moves reader past a sequence without decoding it
+      static void skip(read_buffer<E> &reader) {
+         reader.position(reader.position() + value_or_throw(measure(reader.available_bytes())));
+      }
+
+      [[nodiscard]]
+      iterator begin() const noexcept {
+         return iterator{data_, size_};
+      }
+
+      [[nodiscard]]
+      iterator end() const noexcept {
+         return iterator{};
+      }
+
+      // Number of elements
+      [[nodiscard]]
+      size_type size() const noexcept {
+         return size_;
+      }
+
+   private:
+      template<typename, std::endian>
+      friend class sequence_view;
+
+      sequence_view(std::byte const *const data, size_type const size) noexcept
+         : data_{data},
+           size_{size} {
+      }
+
+      template<typename U>
+      static U load(std::byte const *const in) noexcept {
+         return *read_buffer<E>{std::span{in, sizeof(U)}}.template try_get<U>();
+      }
+
+      template<typename U>
+      static U value_or_throw(std::expected<U, buffer_error> const result) {
+         if (!result) {
+            throw buffer_overflow{"Cannot read sequence from buffer, not enough space remaining"};
+         }
+         return *result;
+      }
+
+      // Encoded size of the sequence at the front of in, checked against in
+      static std::expected<size_type, buffer_error> measure(std::span<std::byte const> const in) noexcept {
+         if (in.size() < sizeof(size_type)) {
+            return std::unexpected{buffer_error::not_enough_space};
+         }
+         auto const n = load<size_type>(in.data());
+         auto const elements = in.subspan(sizeof(size_type));
+         if constexpr (buffer_scalar<T>) {
+            if (elements.size() / sizeof(T) < n) {
+               return std::unexpected{buffer_error::not_enough_space};
+            }
+            return sizeof(size_type) + n * sizeof(T);
+         }
+         else {
+            size_type offset = 0;
+            for (size_type i = 0; i < n; ++i) {
+               auto const element = element_sequence::measure(elements.subspan(offset));
+               if (!element) {
+                  return element;
+               }
+               offset += *element;
+            }
+            return sizeof(size_type) + offset;
+         }
+      }
+
+      // Encoded size of the element at in, which measure has already checked
+      static size_type encoded_size(std::byte const *const in) noexcept {
+         if constexpr (buffer_scalar<T>) {
+            return sizeof(T);
+         }
+         else {
+            return element_sequence::sequence_size(in);
+         }
+      }
+
+      // Encoded size of the sequence at in, which measure has already checked
+      static size_type sequence_size(std::byte const *const in) noexcept {
+         auto const n = load<size_type>(in);
+         if constexpr (buffer_scalar<T>) {
+            return sizeof(size_type) + n * sizeof(T);
+         }
+         else {
+            auto *position = in + sizeof(size_type);
+            for (size_type i = 0; i < n; ++i) {
+               position += encoded_size(position);
+            }
+            return static_cast<size_type>(position - in);
+         }
+      }
+
+      static T decode(std::byte const *const in) noexcept {
+         if constexpr (buffer_scalar<T>) {
+            return load<T>(in);
+         }
+         else {
+            return T{in + sizeof(size_type), load<size_type>(in)};
+         }
+      }
+
+      // The sequence each element is encoded as, when it is not a scalar: byte spans are sequences of bytes
+      using element_sequence = std::conditional_t<std::same_as<T, std::span<std::byte const> >,
+                                                  sequence_view<std::uint8_t, E>, T>;
+
+      std::byte const *data_ = nullptr;
+      size_type size_ = 0;
+   };
+} // io::skizzay::identigen
+
+template<typename T, std::endian E>
+inline constexpr bool std::ranges::enable_borrowed_range<io::skizzay::identigen::sequence_view<T, E> > = true;
@@ -0,0 +1,241 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace io::skizzay::identigen {
+   constexpr inline std::size_t cache_line_size = 64;
+
+   // Assigns every thread a fixed index on first use, so threads are spread round-robin over the shards
+   struct thread_shard_selector final {
+      [[nodiscard]]
+      std::size_t operator()(std::size_t const num_shards) const noexcept {
+         auto const index = thread_index();
+         return index < num_shards ? index : index % num_shards;
+      }
+
+      [[nodiscard]]
+      static std::size_t thread_index() noexcept {
+         static std::atomic<std::size_t> next_index = 0;
+         thread_local std::size_t const index = next_index.fetch_add(1, std::memory_order_relaxed);
+         return index;
+      }
+   };
+
+   // Picks the shard of the CPU the calling thread is running on
+   struct cpu_shard_selector final {
+      [[nodiscard]]
+      std::size_t operator()(std::size_t const num_shards) const noexcept {
+         auto const cpu = value_provider_utilities::current_cpu();
+         return cpu < num_shards ? cpu : cpu % num_shards;
+      }
+   };
+
+   // Generator split into shards, each with its own sequence state on its own cache line. The shard index is packed
+   // into the ID as a value_provider_utilities::from_shard field between the providers and the sequence, so IDs from
+   // different shards never collide and a thread only ever writes to its own shard's cache line. ShardSelector picks
+   // the shard for the calling thread; threads that end up on the same shard remain correct, but contend.
+   template<typename ShardSelector, timestamp_provider TimestampProvider, value_provider... Providers>
+   class basic_sharded_generator {
+      using shard_provider = decltype(value_provider_utilities::from_shard(0, 1));
+      using shard_generator = generator<TimestampProvider, Providers..., shard_provider>;
+
+   public:
+      using layout_type = typename shard_generator::layout_type;
+      using timestamp_type = typename shard_generator::timestamp_type;
+      using id_type = typename shard_generator::id_type;
+
+      basic_sharded_generator(std::size_t const num_shards, TimestampProvider timestamp_provider,
+                              std::size_t const sequence_bits, Providers... providers)
+         : basic_sharded_generator{
+            clock_regression_policy{}, num_shards, std::move(timestamp_provider), sequence_bits, std::move(providers)...
+         } {
+      }
+
+      basic_sharded_generator(clock_regression_policy const policy, std::size_t const num_shards,
+                              TimestampProvider timestamp_provider, std::size_t const sequence_bits,
+                              Providers... providers)
+         : shards_{make_shards(num_shards)},
+           num_shards_{num_shards} {
+         for (std::size_t i = 0; i < num_shards_; ++i) {
+            shards_[i].emplace(policy, timestamp_provider, sequence_bits, providers...,
+                               value_provider_utilities::from_shard(i, num_shards_));
+         }
+      }
+
+      basic_sharded_generator(basic_sharded_generator const &) = delete;
+
+      basic_sharded_generator &operator=(basic_sharded_generator const &) = delete;
+
+      template<key K>
+      [[nodiscard]]
+      id_type next(K const &k) {
+         return current_shard().next(k);
+      }
+
+      [[nodiscard]]
+      id_type next() {
+         return current_shard().next();
+      }
+
+      template<key K>
+      void generate_n(std::span<id_type> const ids, K const &k) {
+         current_shard().generate_n(ids, k);
+      }
+
+      template<typename K>
+      void generate_n(std::span<id_type> const ids, std::span<K> const keys) {
+         current_shard().generate_n(ids, keys);
+      }
+
+      template<key K>
+      [[nodiscard]]
+      std::optional<id_type> try_next(K const &k) {
+         return current_shard().try_next(k);
+      }
+
+      template<key K>
+      [[nodiscard]]
+      std::size_t try_generate_n(std::span<id_type> const ids, K const &k) {
+         return current_shard().try_generate_n(ids, k);
+      }
+
+      [[nodiscard]]
+      std::size_t num_shards() const noexcept {
+         return num_shards_;
+      }
+
+      [[nodiscard]]
+      layout_type const &layout() const noexcept {
+         return shards_[0]->generator.layout();
+      }
+
+      [[nodiscard]]
+      std::size_t num_sequence_bits() const noexcept {
+         return shards_[0]->generator.num_sequence_bits();
+      }
+
+      [[nodiscard]]
+      std::size_t num_significant_bits() const noexcept {
+         return shards_[0]->generator.num_significant_bits();
+      }
+
+      [[nodiscard]]
+      timestamp_type now() {
+         return shards_[0]->generator.now();
+      }
+
+      // Latest high-water mark of any shard
+      [[nodiscard]]
+      timestamp_type high_water_mark() const noexcept {
+         auto result = shards_[0]->generator.high_water_mark();
+         for (std::size_t i = 1; i < num_shards_; ++i) {
+            result = std::max(result, shards_[i]->generator.high_water_mark());
+         }
+         return result;
+      }
+
+      void fast_forward(timestamp_type const ts) noexcept {
+         for (std::size_t i = 0; i < num_shards_; ++i) {
+            shards_[i]->generator.fast_forward(ts);
+         }
+      }
+
+      void issue_until(std::optional<timestamp_type> const ts) noexcept {
+         for (std::size_t i = 0; i < num_shards_; ++i) {
+            shards_[i]->generator.issue_until(ts);
+         }
+      }
+
+   protected:
+      [[nodiscard]]
+      shard_generator &shard(std::size_t const i) noexcept {
+         return shards_[i]->generator;
+      }
+
+   private:
+      struct alignas(cache_line_size) padded_shard final {
+         template<typename... Args>
+         explicit padded_shard(Args &&... args)
+            : generator{std::forward<Args>(args)...} {
+         }
+
+         shard_generator generator;
+      };
+
+      static std::unique_ptr<std::optional<padded_shard>[]> make_shards(std::size_t const num_shards) {
+         if (0 == num_shards) {
+            throw std::invalid_argument{"Cannot create sharded generator, it requires at least one shard"};
+         }
+         return std::make_unique<std::optional<padded_shard>[]>(num_shards);
+      }
+
+      [[nodiscard]]
+      shard_generator &current_shard() noexcept {
+         return shard(selector_(num_shards_));
+      }
+
+      std::unique_ptr<std::optional<padded_shard>[]> shards_;
+      std::size_t const num_shards_;
+      [[no_unique_address]] ShardSelector selector_;
+   };
+
+   // Sharded generator giving each thread its own shard
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   class sharded_generator final
+         : public basic_sharded_generator<thread_shard_selector, TimestampProvider, Providers...> {
+   public:
+      using basic_sharded_generator<thread_shard_selector, TimestampProvider, Providers...>::basic_sharded_generator;
+   };
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   sharded_generator(std::size_t, TimestampProvider, std::size_t, Providers...) -> sharded_generator<
+      TimestampProvider, Providers...>;
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   sharded_generator(clock_regression_policy, std::size_t, TimestampProvider, std::size_t,
+                     Providers...) -> sharded_generator<TimestampProvider, Providers...>;
+
+   // Sharded generator with one shard per CPU, so the shard index in each ID is the CPU it was generated on. A thread
+   // that migrates between reading its CPU and claiming a sequence number only causes a rare uncontended CAS on
+   // another CPU's line; uniqueness never depends on where the thread runs.
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   class per_cpu_generator final
+         : public basic_sharded_generator<cpu_shard_selector, TimestampProvider, Providers...> {
+      using base_type = basic_sharded_generator<cpu_shard_selector, TimestampProvider, Providers...>;
+
+   public:
+      per_cpu_generator(TimestampProvider timestamp_provider, std::size_t const sequence_bits, Providers... providers)
+         : base_type{
+            value_provider_utilities::num_cpus(), std::move(timestamp_provider), sequence_bits, std::move(providers)...
+         } {
+      }
+
+      per_cpu_generator(clock_regression_policy const policy, TimestampProvider timestamp_provider,
+                        std::size_t const sequence_bits, Providers... providers)
+         : base_type{
+            policy, value_provider_utilities::num_cpus(), std::move(timestamp_provider), sequence_bits,
+            std::move(providers)...
+         } {
+      }
+   };
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   per_cpu_generator(TimestampProvider, std::size_t, Providers...) -> per_cpu_generator<TimestampProvider, Providers...>;
+
+   template<timestamp_provider TimestampProvider, value_provider... Providers>
+   per_cpu_generator(clock_regression_policy, TimestampProvider, std::size_t,
+                     Providers...) -> per_cpu_generator<TimestampProvider, Providers...>;
+} // io::skizzay::identigen
@@ -0,0 +1,141 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/key.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   // Strictly increasing split points dividing the keys into size() + 1 ranges, searched for the range holding a key.
+   // The points are stored in Eytzinger (breadth-first) order, so the first levels of every search share cache lines
+   // and the next levels can be prefetched; the search compares without branching and always takes the same number
+   // of steps. Integer keys with at most small_fan_out points are instead compared against all of them at once.
+   template<sortable_key K>
+   class split_index final {
+   public:
+      using size_type = std::size_t;
+
+      static constexpr size_type small_fan_out = 16;
+
+      template<std::ranges::input_range R>
+         requires std::convertible_to<std::ranges::range_reference_t<R>, K>
+      explicit split_index(R &&split_points) {
+         std::vector<K> sorted;
+         for (auto &&point: split_points) {
+            sorted.emplace_back(point);
+         }
+         if (std::ranges::adjacent_find(sorted, std::ranges::greater_equal{}) != sorted.end()) {
+            throw std::invalid_argument{"Cannot create split index, split points must be strictly increasing"};
+         }
+         size_ = sorted.size();
+         // Slot 0 is unused, so that the children of slot i are 2i and 2i + 1. Its rank is where a search for any key
+         // ends when there are no split points.
+         ranks_.assign(size_ + 1, size_);
+         if (!sorted.empty()) {
+            eytzinger_.assign(size_ + 1, sorted.front());
+            size_type next = 0;
+            lay_out(sorted, next, 1);
+         }
+         if constexpr (is_small_codable) {
+            if (size_ <= small_fan_out) {
+               linear_.fill(std::numeric_limits<K>::max());
+               std::ranges::copy(sorted, linear_.begin());
+            }
+         }
+      }
+
+      // Number of split points
+      [[nodiscard]]
+      size_type size() const noexcept {
+         return size_;
+      }
+
+      // Index of the range holding k: the number of split points less than or equal to k
+      [[nodiscard]]
+      size_type rank(K const &k) const noexcept {
+         if constexpr (is_small_codable) {
+            if (size_ <= small_fan_out) {
+               return std::min(count_not_greater(k), size_);
+            }
+         }
+         size_type i = 1;
+         while (i <= size_) {
+            __builtin_prefetch(eytzinger_.data() + prefetch_distance * i);
+            i = 2 * i + static_cast<size_type>(!(k < eytzinger_[i]));
+         }
+         // Undo the moves right after the last move left, whose node is the first split point greater than k
+         return ranks_[i >> (std::countr_one(i) + 1)];
+      }
+
+   private:
+      static constexpr bool is_small_codable = std::integral<K> && !std::same_as<K, bool>;
+
+      // Slots four levels down from i share a cache line for 4-byte keys, which the search reaches four steps later
+      static constexpr size_type prefetch_distance = 16;
+
+      void lay_out(std::vector<K> const &sorted, size_type &next, size_type const i) {
+         if (i <= size_) {
+            lay_out(sorted, next, 2 * i);
+            eytzinger_[i] = sorted[next];
+            ranks_[i] = next++;
+            lay_out(sorted, next, 2 * i + 1);
+         }
+      }
+
+      // Number of the padded split points not greater than k, counting the padding when k is the greatest key
+      [[nodiscard]]
+      size_type count_not_greater(K const k) const noexcept {
+#if defined(__AVX2__)
+         if constexpr (8 == sizeof(K) || 4 == sizeof(K)) {
+            using lane_type = std::conditional_t<8 == sizeof(K), std::int64_t, std::int32_t>;
+            // AVX2 only compares signed lanes: flipping the sign bit orders unsigned keys the same way
+            constexpr auto bias = std::unsigned_integral<K> ? std::numeric_limits<lane_type>::min() : lane_type{0};
+            auto const flip = 8 == sizeof(K) ? _mm256_set1_epi64x(bias) : _mm256_set1_epi32(bias);
+            auto const key = _mm256_xor_si256(8 == sizeof(K) ? _mm256_set1_epi64x(static_cast<lane_type>(k))
+                                                             : _mm256_set1_epi32(static_cast<lane_type>(k)),
+                                              flip);
+            size_type greater = 0;
+            for (size_type i = 0; i < small_fan_out; i += 32 / sizeof(K)) {
+               auto const points = _mm256_xor_si256(
+                  _mm256_loadu_si256(reinterpret_cast<__m256i const *>(linear_.data() + i)), flip);
+               auto const mask = 8 == sizeof(K) ? _mm256_cmpgt_epi64(points, key) : _mm256_cmpgt_epi32(points, key);
+               greater += static_cast<size_type>(std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(mask))))
+                          / sizeof(K);
+            }
+            return small_fan_out - greater;
+         }
+#endif
+         size_type result = 0;
+         for (auto const point: linear_) {
+            result += static_cast<size_type>(point <= k);
+         }
+         return result;
+      }
+
+      struct no_points final {
+      };
+
+      size_type size_ = 0;
+      std::vector<K> eytzinger_;
+      std::vector<size_type> ranks_;
+      [[no_unique_address]] std::conditional_t<is_small_codable, std::array<K, small_fan_out>, no_points> linear_;
+   };
+
+   template<std::ranges::input_range R>
+   split_index(R &&) -> split_index<std::ranges::range_value_t<R> >;
+} // io::skizzay::identigen
@@ -0,0 +1,289 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include "io/skizzay/identigen/buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace io::skizzay::identigen {
+   // Reads what write_buffer<E> wrote from a file descriptor through a fixed window, so memory stays bounded by the
+   // window size however large the input is. The window is refilled with large reads, after telling the kernel the
+   // access is sequential so it reads ahead; whatever is left of the window is moved to its front first, so a value
+   // or length-prefixed span that crosses a refill boundary is decoded from contiguous bytes as usual.
+   //
+   // Spans returned by get() point into the window and stay valid until the next read; a span longer than the window
+   // cannot be read this way (read it with get(std::span<T>) instead). Unlike read_buffer, a failed read leaves the
+   // reader where the failure was found. The file descriptor is not owned.
+   template<std::endian E>
+   class stream_reader final {
+   public:
+      using size_type = std::size_t;
+
+      static constexpr size_type default_window_size = 1024 * 1024;
+
+      struct decoder final {
+         friend class stream_reader;
+
+         template<std::integral I>
+         explicit operator I() {
+            return reader_.decode(sizeof(I), [](read_buffer<E> &r) { return static_cast<I>(r.get()); });
+         }
+
+         explicit operator float() {
+            return reader_.decode(sizeof(float), [](read_buffer<E> &r) { return static_cast<float>(r.get()); });
+         }
+
+         explicit operator double() {
+            return reader_.decode(sizeof(double), [](read_buffer<E> &r) { return static_cast<double>(r.get()); });
+         }
+
+         explicit operator std::span<std::byte const>() {
+            reader_.require(sizeof(size_type));
+            auto const n = static_cast<size_type>(read_buffer<E>{reader_.available_bytes()}.get());
+            if (reader_.window_.size() - sizeof(size_type) < n) {
+               throw buffer_overflow{"Cannot read span from stream, span is larger than the window"};
+            }
+            return reader_.decode(sizeof(size_type) + n, [](read_buffer<E> &r) {
+               return static_cast<std::span<std::byte const> >(r.get());
+            });
+         }
+
+      private:
+         explicit decoder(stream_reader &reader) noexcept
+            : reader_{reader} {
+         }
+
+         stream_reader &reader_;
+      };
+
+      explicit stream_reader(int const fd, size_type const window_size = default_window_size)
+         : fd_{fd},
+           window_(validate_window_size(window_size)) {
+         ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+      }
+
+      stream_reader(stream_reader const &) = delete;
+
+      stream_reader &operator=(stream_reader const &) = delete;
+
+      // Number of bytes consumed
+      [[nodiscard]]
+      size_type position() const noexcept {
+         return consumed_;
+      }
+
+      [[nodiscard]]
+      size_type window_size() const noexcept {
+         return window_.size();
+      }
+
+      // Whether every byte of the input has been consumed
+      [[nodiscard]]
+      bool at_end() {
+         return 0 == fill(1);
+      }
+
+      decoder get() noexcept {
+         return decoder{*this};
+      }
+
+      template<std::integral T>
+      T get_varint() {
+         fill(varint_utilities::max_size<T>);
+         read_buffer<E> r{available_bytes()};
+         auto const x = r.template get_varint<T>();
+         consume(r.position());
+         return x;
+      }
+
+      // Reads a range written by write_buffer::put into the front of values a window at a time, so the range may be
+      // larger than the window. Returns the number of values read.
+      template<typename T, std::size_t N>
+         requires byte_order_utilities::is_bulk_codable<T>
+      size_type get(std::span<T, N> const values) {
+         auto const n = static_cast<size_type>(get());
+         if (values.size() < n) {
+            throw std::out_of_range{"Cannot read range from stream, not enough space for the values"};
+         }
+         for (size_type read = 0; read < n;) {
+            require(sizeof(T));
+            auto const count = std::min(n - read, available() / sizeof(T));
+            byte_order_utilities::decode<E>(window_.data() + begin_, std::span<T>{values}.subspan(read, count));
+            consume(count * sizeof(T));
+            read += count;
+         }
+         return n;
+      }
+
+   private:
+      static size_type validate_window_size(size_type const window_size) {
+         if (window_size < minimum_window_size) {
+            throw std::invalid_argument{"Cannot create stream reader, window is too small"};
+         }
+         return window_size;
+      }
+
+      // Room for the widest scalar, so that any value can be made contiguous
+      static constexpr size_type minimum_window_size = 16;
+
+      [[nodiscard]]
+      size_type available() const noexcept {
+         return end_ - begin_;
+      }
+
+      [[nodiscard]]
+      std::span<std::byte const> available_bytes() const noexcept {
+         return std::span<std::byte const>{window_}.subspan(begin_, available());
+      }
+
+      void consume(size_type const n) noexcept {
+         begin_ += n;
+         consumed_ += n;
+      }
+
+      // Tries to have n contiguous bytes available, moving what is left to the front of the window if they would not
+      // fit behind it. Returns the number available, which is less than n only at the end of the input.
+      size_type fill(size_type const n) {
+         if (n <= available()) {
+            return available();
+         }
+         if (window_.size() - begin_ < n) {
+            std::memmove(window_.data(), window_.data() + begin_, available());
+            end_ = available();
+            begin_ = 0;
+         }
+         while (available() < n && !eof_) {
+            auto const result = ::read(fd_, window_.data() + end_, window_.size() - end_);
+            if (result < 0) {
+               if (EINTR == errno) {
+                  continue;
+               }
+               throw std::system_error{errno, std::generic_category(), "Cannot read from stream"};
+            }
+            eof_ = 0 == result;
+            end_ += static_cast<size_type>(result);
+         }
+         return available();
+      }
+
+      void require(size_type const n) {
+         if (fill(n) < n) {
+            throw buffer_overflow{"Cannot read value from stream, not enough bytes remaining"};
+         }
+      }
+
+      template<typename Decode>
+      auto decode(size_type const n, Decode const &decode) {
+         require(n);
+         read_buffer<E> r{available_bytes().first(n)};
+         auto const result = decode(r);
+         consume(r.position());
+         return result;
+      }
+
+      int const fd_;
+      std::vector<std::byte> window_;
+      size_type begin_ = 0;
+      size_type end_ = 0;
+      size_type consumed_ = 0;
+      bool eof_ = false;
+   };
+
+   // Read-only mapping of a whole file, to decode with read_buffer<E> directly. The kernel pages the file in and out
+   // as it is read, so resident memory is bounded by the page cache rather than the file size; the hints make it read
+   // ahead aggressively and discard() drops pages that have been decoded already.
+   class mapped_file final {
+   public:
+      enum class access_pattern {
+         normal = MADV_NORMAL,
+         sequential = MADV_SEQUENTIAL,
+         random = MADV_RANDOM
+      };
+
+      explicit mapped_file(std::filesystem::path const &path, access_pattern const pattern = access_pattern::sequential) {
+         auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+         if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), "Cannot open mapped file"};
+         }
+         struct ::stat status = {};
+         if (0 != ::fstat(fd, &status)) {
+            auto const error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), "Cannot size mapped file"};
+         }
+         size_ = static_cast<std::size_t>(status.st_size);
+         if (0 < size_) {
+            auto *const mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED == mapping) {
+               auto const error = errno;
+               ::close(fd);
+               throw std::system_error{error, std::generic_category(), "Cannot map file"};
+            }
+            data_ = static_cast<std::byte const *>(mapping);
+            ::madvise(mapping, size_, static_cast<int>(pattern));
+         }
+         ::close(fd);
+      }
+
+      mapped_file(mapped_file const &) = delete;
+
+      mapped_file &operator=(mapped_file const &) = delete;
+
+      ~mapped_file() {
+         if (nullptr != data_) {
+            ::munmap(const_cast<std::byte *>(data_), size_);
+         }
+      }
+
+      [[nodiscard]]
+      std::span<std::byte const> bytes() const noexcept {
+         return {data_, size_};
+      }
+
+      // Asks the kernel to start reading [offset, offset + length) now
+      void will_need(std::size_t const offset, std::size_t const length) const noexcept {
+         advise(offset, length, MADV_WILLNEED);
+      }
+
+      // Drops the pages of [0, offset) from memory; reading them again pages them back in from the file
+      void discard(std::size_t const offset) const noexcept {
+         advise(0, offset, MADV_DONTNEED);
+      }
+
+   private:
+      void advise(std::size_t offset, std::size_t length, int const advice) const noexcept {
+         length = std::min(length, size_ - std::min(offset, size_));
+         if (0 == length) {
+            return;
+         }
+         // madvise takes page-aligned ranges: widen to whole pages, except for discard which must not reach past offset
+         // unless the range runs to the end of the file, where the rest of the last page holds nothing
+         auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+         auto const end = MADV_DONTNEED == advice && offset + length < size_ ? (offset + length) / page * page
+                          : (offset + length + page - 1) / page * page;
+         offset = offset / page * page;
+         if (offset < end) {
+            ::madvise(const_cast<std::byte *>(data_) + offset, end - offset, advice);
+         }
+      }
+
+      std::byte const *data_ = nullptr;
+      std::size_t size_ = 0;
+   };
+} // io::skizzay::identigen
@@ -5,9 +5,26 @@
 #pragma once
 
 #include "io/skizzay/identigen/timestamp_provider.h"
+#include "io/skizzay/identigen/hash.h"
 #include "io/skizzay/identigen/key.h"
+#include "io/skizzay/identigen/split_index.h"
 
+#include <algorithm>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <utility>
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#endif
+#endif
 
 namespace io::skizzay::identigen {
    template<typename T>
@@ -38,8 +55,117 @@ namespace io::skizzay::identigen {
          return constant_value_provider{value, calculate_num_significant_bits(value)};
       }
 
-      static constexpr value_provider auto partitioned(std::size_t const num_buckets) noexcept {
-         return key_value_provider{num_buckets, calculate_num_significant_bits(num_buckets - 1)};
+      // Constant index of one of num_shards shards, always occupying the bits needed for the largest shard index
+      static constexpr value_provider auto from_shard(std::size_t const shard, std::size_t const num_shards) noexcept {
+         return constant_value_provider{shard, calculate_num_significant_bits(num_shards - 1)};
+      }
+
+      // Bucket of each key as the remainder of its hash by num_buckets, computed by multiplying with a precomputed
+      // reciprocal rather than dividing. Keys are hashed with hash, std::hash by default; std::hash is the identity for
+      // integers, so integer keys sharing a stride with num_buckets share a bucket unless hashed with key_hash.
+      template<typename Hash = standard_hash>
+      static constexpr value_provider auto partitioned(std::size_t const num_buckets, Hash const hash = {}) noexcept {
+         return key_value_provider{modulo_reduction{num_buckets}, hash, calculate_num_significant_bits(num_buckets - 1)};
+      }
+
+      // Bucket of each key by mixing its hash and scaling it onto num_buckets with one multiply and shift (Lemire's
+      // range reduction). The cheapest and most evenly spread of the partitionings, but changing num_buckets moves
+      // nearly every key to another bucket.
+      template<typename Hash = standard_hash>
+      static constexpr value_provider auto partitioned_uniform(std::size_t const num_buckets,
+                                                               Hash const hash = {}) noexcept {
+         return key_value_provider{multiply_shift_reduction{num_buckets}, hash,
+                                   calculate_num_significant_bits(num_buckets - 1)};
+      }
+
+      // Bucket of each key by jump consistent hash (Lamping and Veach) of its mixed hash: growing to n buckets moves
+      // only 1/n of the keys, all into the new bucket, and shrinking only moves the keys of the buckets removed. Takes
+      // O(log num_buckets) steps per key. The bits are sized for max_buckets, so that the number of buckets can be
+      // changed without changing the layout of the IDs. The count is fixed once the provider is in a generator; to
+      // change it, stop issuing from the old generator, make a new one with the new provider, and fast-forward it past
+      // the old one's high-water mark, as a key that keeps its bucket would otherwise get the same IDs from both.
+      template<typename Hash = standard_hash>
+      static constexpr value_provider auto partitioned_consistent(std::size_t const num_buckets,
+                                                                  std::size_t const max_buckets = 0,
+                                                                  Hash const hash = {}) noexcept {
+         return key_value_provider{jump_reduction{num_buckets}, hash,
+                                   calculate_num_significant_bits(std::max(num_buckets, max_buckets) - 1)};
+      }
+
+      // Bucket of each key by the range of split_points it falls in: keys below the first split point are in bucket 0,
+      // keys from the first up to the second in bucket 1, and so on. Keys adjacent in order get adjacent buckets.
+      // Throws std::invalid_argument unless split_points is strictly increasing.
+      template<std::ranges::input_range R>
+      static value_provider auto range_partitioned(R &&split_points) {
+         split_index index{std::forward<R>(split_points)};
+         auto const significant_bits = calculate_num_significant_bits(index.size());
+         return range_value_provider<std::ranges::range_value_t<R> >{std::move(index), significant_bits};
+      }
+
+      // Index of the CPU the calling thread is running on, sized for every CPU configured on the host
+      static value_provider auto from_current_cpu() {
+         return cpu_value_provider{false, calculate_num_significant_bits(num_cpus() - 1)};
+      }
+
+      // Index of the NUMA node the calling thread is running on, sized for every possible node on the host
+      static value_provider auto from_current_numa_node() {
+         return cpu_value_provider{true, calculate_num_significant_bits(num_numa_nodes() - 1)};
+      }
+
+      // Reads the CPU id the kernel publishes in the thread's restartable sequence area when glibc has registered one,
+      // which is a plain load, falling back to sched_getcpu. The thread may migrate as soon as this returns, so the
+      // result must only be used for locality, never for exclusive ownership.
+      [[nodiscard]]
+      static std::size_t current_cpu() noexcept {
+#if defined(__linux__)
+#if defined(__GLIBC_HAVE_KERNEL_RSEQ)
+         if (0 < __rseq_size) {
+            auto const *area = reinterpret_cast<struct rseq const volatile *>(
+               static_cast<char const *>(__builtin_thread_pointer()) + __rseq_offset);
+            if (auto const cpu = static_cast<std::int32_t>(area->cpu_id); 0 <= cpu) {
+               return static_cast<std::size_t>(cpu);
+            }
+         }
+#endif
+         auto const cpu = sched_getcpu();
+         return cpu < 0 ? 0 : static_cast<std::size_t>(cpu);
+#else
+         return 0;
+#endif
+      }
+
+      [[nodiscard]]
+      static std::size_t current_numa_node() noexcept {
+#if defined(__linux__)
+         unsigned cpu = 0;
+         unsigned node = 0;
+         return 0 == getcpu(&cpu, &node) ? node : 0;
+#else
+         return 0;
+#endif
+      }
+
+      // Configured rather than online CPUs, as online CPU ids may be sparse
+      [[nodiscard]]
+      static std::size_t num_cpus() noexcept {
+#if defined(__linux__)
+         if (auto const n = sysconf(_SC_NPROCESSORS_CONF); 0 < n) {
+            return static_cast<std::size_t>(n);
+         }
+#endif
+         return std::max(1u, std::thread::hardware_concurrency());
+      }
+
+      [[nodiscard]]
+      static std::size_t num_numa_nodes() {
+         // The possible node list looks like "0" or "0-3"
+         std::ifstream possible{"/sys/devices/system/node/possible"};
+         std::string nodes;
+         if (possible >> nodes) {
+            auto const last = nodes.find_last_of("-,");
+            return std::stoul(std::string::npos == last ? nodes : nodes.substr(last + 1)) + 1;
+         }
+         return 1;
       }
 
       template<timestamp T>
@@ -54,7 +180,7 @@ namespace io::skizzay::identigen {
          std::size_t const significant_bits;
 
          [[nodiscard]]
-         constexpr std::size_t value(timestamp auto const, key auto const) const noexcept {
+         constexpr std::size_t value(timestamp auto const, key auto const &) const noexcept {
             return x;
          }
 
@@ -64,13 +190,105 @@ namespace io::skizzay::identigen {
          }
       };
 
+      // x % num_buckets as the high bits of the fraction x / num_buckets, which needs 128 bits of reciprocal to be
+      // exact for any 64-bit x (Lemire, Kaser and Kurz, "Faster Remainder by Direct Computation")
+      struct modulo_reduction final {
+         std::uint64_t const num_buckets;
+         unsigned __int128 const reciprocal;
+
+         explicit constexpr modulo_reduction(std::size_t const n) noexcept
+            : num_buckets{n},
+              reciprocal{~static_cast<unsigned __int128>(0) / n + 1} {
+         }
+
+         [[nodiscard]]
+         constexpr std::size_t operator()(std::uint64_t const x) const noexcept {
+            auto const fraction = reciprocal * x;
+            auto const low = static_cast<unsigned __int128>(static_cast<std::uint64_t>(fraction)) * num_buckets;
+            auto const high = (fraction >> 64) * num_buckets;
+            return static_cast<std::size_t>((high + (low >> 64)) >> 64);
+         }
+      };
+
+      struct multiply_shift_reduction final {
+         std::uint64_t const num_buckets;
+
+         [[nodiscard]]
+         constexpr std::size_t operator()(std::uint64_t const x) const noexcept {
+            return static_cast<std::size_t>((static_cast<unsigned __int128>(hash_utilities::mix(x)) * num_buckets) >> 64);
+         }
+      };
+
+      struct jump_reduction final {
+         std::int64_t const num_buckets;
+
+         explicit constexpr jump_reduction(std::size_t const n) noexcept
+            : num_buckets{static_cast<std::int64_t>(n)} {
+         }
+
+         [[nodiscard]]
+         constexpr std::size_t operator()(std::uint64_t const x) const noexcept {
+            auto state = hash_utilities::mix(x);
+            std::int64_t bucket = 0;
+            for (std::int64_t next = 0; next < num_buckets;) {
+               bucket = next;
+               state = state * 2862933555777941757 + 1;
+               next = static_cast<std::int64_t>(static_cast<double>(bucket + 1) *
+                                                (static_cast<double>(std::int64_t{1} << 31) /
+                                                 static_cast<double>((state >> 33) + 1)));
+            }
+            return static_cast<std::size_t>(bucket);
+         }
+      };
+
+      template<typename Reduction, typename Hash>
       struct key_value_provider final {
-         std::size_t const num_buckets;
+         Reduction const reduce;
+         [[no_unique_address]] Hash const hash;
+         std::size_t const significant_bits;
+
+         template<typename K>
+            requires key<K, Hash>
+         [[nodiscard]]
+         constexpr std::size_t value(timestamp auto const, K const &k) const noexcept {
+            return reduce(hash(k));
+         }
+
+         [[nodiscard]]
+         constexpr std::size_t num_significant_bits() const noexcept {
+            return significant_bits;
+         }
+      };
+
+      template<sortable_key K>
+      struct range_value_provider final {
+         split_index<K> const index;
+         std::size_t const significant_bits;
+
+         [[nodiscard]]
+         std::size_t value(timestamp auto const, K const &k) const noexcept {
+            return index.rank(k);
+         }
+
+         template<typename Hash>
+         [[nodiscard]]
+         std::size_t value(timestamp auto const, hashed_key<K, Hash> const &k) const noexcept {
+            return index.rank(k.get());
+         }
+
+         [[nodiscard]]
+         constexpr std::size_t num_significant_bits() const noexcept {
+            return significant_bits;
+         }
+      };
+
+      struct cpu_value_provider final {
+         bool const numa_node;
          std::size_t const significant_bits;
 
          [[nodiscard]]
-         constexpr std::size_t value(timestamp auto const, key auto const k) const noexcept {
-            return std::hash<std::remove_cv_t<decltype(k)>>{}(k) % num_buckets;
+         std::size_t value(timestamp auto const, key auto const &) const noexcept {
+            return numa_node ? current_numa_node() : current_cpu();
          }
 
          [[nodiscard]]
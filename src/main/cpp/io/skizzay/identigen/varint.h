@@ -0,0 +1,179 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#if defined(__SSE2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace io::skizzay::identigen {
+   // Unsigned LEB128 varints: seven bits per byte, least significant group first, with the high bit set on every byte
+   // but the last. Signed values are zigzag encoded first, so small magnitudes of either sign stay short.
+   struct varint_utilities {
+      varint_utilities() = delete;
+
+      template<std::integral T>
+      static constexpr std::size_t max_size = (std::numeric_limits<std::make_unsigned_t<T> >::digits + 6) / 7;
+
+      static constexpr std::uint64_t zigzag_encode(std::int64_t const x) noexcept {
+         return (static_cast<std::uint64_t>(x) << 1) ^ static_cast<std::uint64_t>(x >> 63);
+      }
+
+      static constexpr std::int64_t zigzag_decode(std::uint64_t const x) noexcept {
+         return static_cast<std::int64_t>(x >> 1) ^ -static_cast<std::int64_t>(x & 1);
+      }
+
+      template<std::integral T>
+      static constexpr std::uint64_t to_unsigned(T const x) noexcept {
+         if constexpr (std::signed_integral<T>) {
+            return zigzag_encode(x);
+         }
+         else {
+            return x;
+         }
+      }
+
+      template<std::integral T>
+      static constexpr T from_unsigned(std::uint64_t const x) noexcept {
+         if constexpr (std::signed_integral<T>) {
+            return static_cast<T>(zigzag_decode(x));
+         }
+         else {
+            return static_cast<T>(x);
+         }
+      }
+
+      // Number of bytes x takes once encoded
+      static constexpr std::size_t size(std::uint64_t const x) noexcept {
+         return 1 + static_cast<std::size_t>(63 - std::countl_zero(x | 1)) / 7;
+      }
+
+      // Writes x to out, which must have room for size(x) bytes, and returns the number of bytes written
+      static std::size_t encode(std::uint64_t x, std::byte *const out) noexcept {
+         std::size_t n = 0;
+         for (; 0x80 <= x; x >>= 7) {
+            out[n++] = static_cast<std::byte>(x | 0x80);
+         }
+         out[n++] = static_cast<std::byte>(x);
+         return n;
+      }
+
+      // Reads one varint from the first available bytes of in. Returns the number of bytes consumed, or 0 if in does
+      // not start with a complete varint whose value fits T.
+      template<std::integral T>
+      static std::size_t decode(std::byte const *const in, std::size_t const available, T &x) noexcept {
+         if constexpr (std::endian::little == std::endian::native) {
+            if (sizeof(std::uint64_t) <= available) {
+               std::uint64_t word;
+               // Inlined into a reader over a buffer shorter than a word, GCC sees this load overrun the buffer even
+               // though the guard above never lets it run there
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+               std::memcpy(&word, in, sizeof(word));
+#pragma GCC diagnostic pop
+               if (auto const stops = ~word & continuation_bits; 0 != stops) {
+                  auto const length = static_cast<std::size_t>(std::countr_zero(stops)) / 8 + 1;
+                  auto const bytes = 8 == length ? word : word & ((std::uint64_t{1} << (8 * length)) - 1);
+                  return store(gather(bytes), length, x);
+               }
+            }
+         }
+         std::uint64_t value = 0;
+         auto const limit = std::min(available, max_size<T>);
+         for (std::size_t i = 0; i < limit; ++i) {
+            auto const b = static_cast<std::uint8_t>(in[i]);
+            auto const group = static_cast<std::uint64_t>(b & 0x7f);
+            if (9 == i && 1 < group) {
+               return 0;
+            }
+            value |= group << (7 * i);
+            if (0 == (b & 0x80)) {
+               return store(value, i + 1, x);
+            }
+         }
+         return 0;
+      }
+
+      struct decode_result final {
+         std::size_t values;
+         std::size_t bytes;
+      };
+
+      // Reads values.size() varints from the first available bytes of in. Runs of single-byte varints, the common
+      // case for counts and deltas, are found sixteen at a time with one movemask (eight at a time with SWAR where
+      // SSE2 is unavailable) and widened without branching; longer varints gather their 7-bit groups from one 8-byte
+      // load. Stops at the first varint that is incomplete or does not fit T, reporting how far it got.
+      template<std::integral T>
+      static decode_result decode_n(std::byte const *const in, std::size_t const available,
+                                    std::span<T> const values) noexcept {
+         std::size_t i = 0;
+         std::size_t position = 0;
+         for (;;) {
+            std::size_t run = 0;
+#if defined(__SSE2__)
+            if (i + 16 <= values.size() && position + 16 <= available) {
+               auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in + position));
+               auto const mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+               run = 0 == mask ? 16 : static_cast<std::size_t>(std::countr_zero(mask));
+            }
+#else
+            if (std::endian::little == std::endian::native && i + 8 <= values.size() && position + 8 <= available) {
+               std::uint64_t word;
+               std::memcpy(&word, in + position, sizeof(word));
+               auto const mask = word & continuation_bits;
+               run = 0 == mask ? 8 : static_cast<std::size_t>(std::countr_zero(mask)) / 8;
+            }
+#endif
+            for (std::size_t j = 0; j < run; ++j) {
+               values[i + j] = from_unsigned<T>(static_cast<std::uint8_t>(in[position + j]));
+            }
+            i += run;
+            position += run;
+            if (values.size() == i) {
+               return {i, position};
+            }
+            auto const consumed = decode(in + position, available - position, values[i]);
+            if (0 == consumed) {
+               return {i, position};
+            }
+            ++i;
+            position += consumed;
+         }
+      }
+
+   private:
+      static constexpr std::uint64_t continuation_bits = 0x8080808080808080;
+
+      // Packs the 7-bit groups in the bytes of word into the low bits of the result
+      static std::uint64_t gather(std::uint64_t const word) noexcept {
+#if defined(__BMI2__)
+         return _pext_u64(word, 0x7f7f7f7f7f7f7f7f);
+#else
+         auto x = word & 0x7f7f7f7f7f7f7f7f;
+         x = (x & 0x007f007f007f007f) | ((x & 0x7f007f007f007f00) >> 1);
+         x = (x & 0x00003fff00003fff) | ((x & 0x3fff00003fff0000) >> 2);
+         return (x & 0x000000000fffffff) | ((x & 0x0fffffff00000000) >> 4);
+#endif
+      }
+
+      template<std::integral T>
+      static std::size_t store(std::uint64_t const value, std::size_t const length, T &x) noexcept {
+         if (max_size<T> < length || std::numeric_limits<std::make_unsigned_t<T> >::max() < value) {
+            return 0;
+         }
+         x = from_unsigned<T>(value);
+         return length;
+      }
+   };
+} // io::skizzay::identigen
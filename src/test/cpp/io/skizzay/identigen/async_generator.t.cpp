@@ -0,0 +1,252 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/async_generator.h>
+#include <io/skizzay/identigen/generator.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+using namespace std::chrono;
+
+namespace {
+   // Eagerly started coroutine that frees itself on completion
+   struct detached final {
+      struct promise_type final {
+         detached get_return_object() noexcept {
+            return {};
+         }
+
+         std::suspend_never initial_suspend() noexcept {
+            return {};
+         }
+
+         std::suspend_never final_suspend() noexcept {
+            return {};
+         }
+
+         void return_void() noexcept {
+         }
+
+         void unhandled_exception() {
+            throw;
+         }
+      };
+   };
+
+   using wheel = timer_wheel<steady_clock>;
+
+   struct counting_timer final : wheel::timer {
+      std::vector<int> *fired;
+      int id;
+
+      counting_timer(std::vector<int> &f, int const i)
+         : fired{&f},
+           id{i} {
+         fire = [](wheel::timer &t) {
+            auto &self = static_cast<counting_timer &>(t);
+            self.fired->push_back(self.id);
+         };
+      }
+   };
+}
+
+TEST_CASE("timer_wheel fires timers once their deadline has passed", "[async_generator]") {
+   auto const start = steady_clock::time_point{};
+   wheel target{milliseconds{1}, 8, start};
+   std::vector<int> fired;
+   counting_timer first{fired, 1};
+   counting_timer second{fired, 2};
+   counting_timer far{fired, 3};
+   target.schedule(second, start + milliseconds{5});
+   target.schedule(first, start + milliseconds{2});
+   target.schedule(far, start + milliseconds{20});
+   REQUIRE(target.advance(start + milliseconds{1}) == 0);
+   REQUIRE(target.advance(start + milliseconds{3}) == 1);
+   REQUIRE(fired == std::vector{1});
+   REQUIRE(target.advance(start + milliseconds{12}) == 1);
+   REQUIRE(fired == std::vector{1, 2});
+   REQUIRE_FALSE(target.empty());
+   REQUIRE(target.advance(start + milliseconds{20}) == 1);
+   REQUIRE(fired == std::vector{1, 2, 3});
+   REQUIRE(target.empty());
+}
+
+TEST_CASE("timer_wheel fires overdue timers on the next advance", "[async_generator]") {
+   auto const start = steady_clock::time_point{};
+   wheel target{milliseconds{1}, 4, start};
+   std::vector<int> fired;
+   counting_timer late{fired, 1};
+   REQUIRE(target.advance(start + milliseconds{100}) == 0);
+   target.schedule(late, start);
+   REQUIRE(target.advance(start + milliseconds{101}) == 1);
+   REQUIRE(fired == std::vector{1});
+}
+
+TEST_CASE("timer_wheel fires timers on the first advance at or after their deadline", "[async_generator]") {
+   auto const start = steady_clock::time_point{};
+   wheel target{milliseconds{10}, 8, start};
+   std::vector<int> fired;
+   counting_timer first{fired, 1};
+   counting_timer second{fired, 2};
+   target.schedule(first, start + milliseconds{15});
+   target.schedule(second, start + milliseconds{17});
+   REQUIRE(target.advance(start + milliseconds{14}) == 0);
+   REQUIRE(target.advance(start + milliseconds{17}) == 2);
+   REQUIRE(fired == std::vector{1, 2});
+}
+
+TEST_CASE("timer_wheel lets a firing timer cancel another due timer", "[async_generator]") {
+   struct cancelling_timer final : wheel::timer {
+      wheel *owner;
+      wheel::timer *victim;
+      int *fired;
+   };
+
+   auto const start = steady_clock::time_point{};
+   wheel target{milliseconds{1}, 8, start};
+   int fired = 0;
+   cancelling_timer first{{}, &target, nullptr, &fired};
+   cancelling_timer second{{}, &target, nullptr, &fired};
+   first.victim = &second;
+   second.victim = &first;
+   first.fire = second.fire = [](wheel::timer &t) {
+      auto &self = static_cast<cancelling_timer &>(t);
+      ++*self.fired;
+      self.owner->cancel(*self.victim);
+   };
+   target.schedule(first, start + milliseconds{2});
+   target.schedule(second, start + milliseconds{2});
+   REQUIRE(target.advance(start + milliseconds{5}) == 1);
+   REQUIRE(fired == 1);
+   REQUIRE(target.empty());
+}
+
+TEST_CASE("async_generator completes without suspending while sequence numbers are left", "[async_generator]") {
+   std::atomic<std::int64_t> now{0};
+   generator gen{manual_clock{&now}, 2};
+   wheel w{milliseconds{1}};
+   async_generator target{gen, w};
+   std::vector<std::uint64_t> ids;
+   [](async_generator<decltype(gen)> &g, std::vector<std::uint64_t> &out) -> detached {
+      out.push_back(co_await g.next(std::size_t{}));
+      out.push_back(co_await g.next(std::size_t{}));
+   }(target, ids);
+   REQUIRE(ids == std::vector<std::uint64_t>{0, 1});
+   REQUIRE(w.empty());
+}
+
+TEST_CASE("async_generator parks on sequence exhaustion until the next tick", "[async_generator]") {
+   std::atomic<std::int64_t> now{0};
+   generator gen{manual_clock{&now}, 1};
+   auto const start = steady_clock::time_point{};
+   wheel w{milliseconds{1}, 16, start};
+   async_generator target{gen, w};
+   std::vector<std::uint64_t> ids;
+   [](async_generator<decltype(gen)> &g, std::vector<std::uint64_t> &out) -> detached {
+      for (int i = 0; i < 3; ++i) {
+         out.push_back(co_await g.next(std::size_t{}));
+      }
+   }(target, ids);
+   REQUIRE(ids.size() == 2);
+   REQUIRE_FALSE(w.empty());
+
+   // The generator's clock has not moved, so the coroutine parks again
+   REQUIRE(w.advance(start + milliseconds{1}) == 1);
+   REQUIRE(ids.size() == 2);
+   REQUIRE_FALSE(w.empty());
+
+   now = 1;
+   REQUIRE(w.advance(start + milliseconds{2}) == 1);
+   REQUIRE(ids.size() == 3);
+   REQUIRE(w.empty());
+}
+
+TEST_CASE("async_generator fills a batch across ticks", "[async_generator]") {
+   std::atomic<std::int64_t> now{0};
+   generator gen{manual_clock{&now}, 2, value_provider_utilities::from_timestamp(sys_time<milliseconds>{},
+                                                                              milliseconds{1 << 10})};
+   auto const start = steady_clock::time_point{};
+   wheel w{milliseconds{1}, 16, start};
+   async_generator target{gen, w};
+   std::array<std::uint64_t, 10> ids{};
+   bool done = false;
+   [](async_generator<decltype(gen)> &g, std::span<std::uint64_t> out, bool &finished) -> detached {
+      co_await g.generate_n(out, std::size_t{});
+      finished = true;
+   }(target, ids, done);
+   REQUIRE_FALSE(done);
+   now = 1;
+   w.advance(start + milliseconds{1});
+   REQUIRE_FALSE(done);
+   now = 2;
+   w.advance(start + milliseconds{2});
+   REQUIRE(done);
+   REQUIRE(ids == std::array<std::uint64_t, 10>{0, 1, 2, 3, (1 << 2) | 0, (1 << 2) | 1, (1 << 2) | 2, (1 << 2) | 3,
+                                                (2 << 2) | 0, (2 << 2) | 1});
+}
+
+TEST_CASE("generator try_next returns nothing instead of waiting", "[async_generator]") {
+   std::atomic<std::int64_t> now{0};
+   generator gen{manual_clock{&now}, 1};
+   REQUIRE(gen.try_next(std::size_t{}) == 0u);
+   REQUIRE(gen.try_next(std::size_t{}) == 1u);
+   REQUIRE_FALSE(gen.try_next(std::size_t{}).has_value());
+   std::array<std::uint64_t, 3> ids{};
+   REQUIRE(gen.try_generate_n(std::span{ids}, std::size_t{}) == 0);
+   now = 1;
+   REQUIRE(gen.try_generate_n(std::span{ids}, std::size_t{}) == 2);
+}
+
+TEST_CASE("async_generator takes a destroyed coroutine off the wheel", "[async_generator]") {
+   // Coroutine whose frame the caller destroys
+   struct owned final {
+      struct promise_type final {
+         owned get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+         }
+
+         std::suspend_never initial_suspend() noexcept {
+            return {};
+         }
+
+         std::suspend_always final_suspend() noexcept {
+            return {};
+         }
+
+         void return_void() noexcept {
+         }
+
+         void unhandled_exception() {
+            throw;
+         }
+      };
+
+      std::coroutine_handle<promise_type> handle;
+   };
+
+   std::atomic<std::int64_t> now{0};
+   generator gen{manual_clock{&now}, 0};
+   auto const start = steady_clock::time_point{};
+   wheel w{milliseconds{1}, 16, start};
+   async_generator target{gen, w};
+   auto const parked = [](async_generator<decltype(gen)> &g) -> owned {
+      for (;;) {
+         static_cast<void>(co_await g.next(std::size_t{}));
+      }
+   };
+   auto first = parked(target);
+   auto second = parked(target);
+   REQUIRE_FALSE(w.empty());
+   first.handle.destroy();
+   second.handle.destroy();
+   REQUIRE(w.empty());
+   REQUIRE(w.advance(start + milliseconds{5}) == 0);
+}
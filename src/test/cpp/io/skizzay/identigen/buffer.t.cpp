@@ -5,6 +5,10 @@
 #include <io/skizzay/identigen/buffer.h>
 #include <catch2/catch_all.hpp>
 
+#include <string>
+#include <tuple>
+#include <vector>
+
 using namespace io::skizzay::identigen;
 
 template<typename T>
@@ -97,4 +101,268 @@ TEST_CASE("write_buffer can write in big endian", "[write_buffer]") {
    REQUIRE(buffer[1] == std::byte{0x34});
    REQUIRE(buffer[2] == std::byte{0x56});
    REQUIRE(buffer[3] == std::byte{0x78});
-}
\ No newline at end of file
+}
+TEMPLATE_TEST_CASE_SIG("read_buffer can read ranges written in bulk by a write_buffer", "[read_buffer,write_buffer]",
+                       ((std::endian E, typename T), E, T), (std::endian::little, std::int16_t),
+                       (std::endian::little, std::uint32_t), (std::endian::little, std::int64_t),
+                       (std::endian::little, float), (std::endian::little, double),
+                       (std::endian::big, std::int16_t), (std::endian::big, std::uint32_t),
+                       (std::endian::big, std::int64_t), (std::endian::big, float), (std::endian::big, double)) {
+   std::vector<T> expected(37);
+   for (std::size_t i = 0; i < expected.size(); ++i) {
+      expected[i] = static_cast<T>(i * 0x01020304050607 + 1);
+   }
+   std::vector<std::byte> buffer(sizeof(std::size_t) + expected.size() * sizeof(T));
+   write_buffer<E> writer{buffer};
+   writer.put(expected);
+   REQUIRE(writer.remaining() == 0);
+
+   std::vector<T> actual(expected.size() + 3);
+   read_buffer<E> reader{writer.to_input_buffer()};
+   REQUIRE(reader.get(std::span{actual}) == expected.size());
+   REQUIRE(reader.remaining() == 0);
+   actual.resize(expected.size());
+   REQUIRE(actual == expected);
+
+   // Matches writing each value on its own
+   std::vector<std::byte> one_by_one(buffer.size());
+   write_buffer<E> single_writer{one_by_one};
+   single_writer.put(expected.size());
+   for (auto const x: expected) {
+      single_writer.put(x);
+   }
+   REQUIRE(one_by_one == buffer);
+}
+
+TEST_CASE("write_buffer writes ranges in bulk in big endian", "[write_buffer]") {
+   std::array<std::uint32_t, 2> const values = {0x12345678, 0x9abcdef0};
+   std::array<std::byte, sizeof(std::size_t) + sizeof(values)> buffer{};
+   write_buffer<std::endian::big> writer{buffer};
+   writer.put(values);
+   auto const payload = std::span{buffer}.subspan(sizeof(std::size_t));
+   REQUIRE(payload[0] == std::byte{0x12});
+   REQUIRE(payload[3] == std::byte{0x78});
+   REQUIRE(payload[4] == std::byte{0x9a});
+   REQUIRE(payload[7] == std::byte{0xf0});
+}
+
+TEST_CASE("write_buffer does not write a partial range", "[write_buffer]") {
+   std::array<std::uint64_t, 4> const values = {1, 2, 3, 4};
+   std::array<std::byte, sizeof(std::size_t) + sizeof(values) - 1> buffer{};
+   write_buffer<std::endian::big> writer{buffer};
+   REQUIRE_THROWS_AS(writer.put(values), buffer_overflow);
+   REQUIRE(writer.position() == 0);
+}
+
+TEST_CASE("read_buffer restores its position when a range does not fit", "[read_buffer]") {
+   std::array<std::uint64_t, 4> const values = {1, 2, 3, 4};
+   std::array<std::byte, sizeof(std::size_t) + sizeof(values)> buffer{};
+   write_buffer<std::endian::little> writer{buffer};
+   writer.put(values);
+   read_buffer<std::endian::little> reader{writer.to_input_buffer()};
+   std::array<std::uint64_t, 3> too_small{};
+   REQUIRE_THROWS_AS(reader.get(std::span{too_small}), std::out_of_range);
+   REQUIRE(reader.position() == 0);
+
+   read_buffer<std::endian::little> truncated{writer.to_input_buffer(0, buffer.size() - 1)};
+   std::array<std::uint64_t, 4> actual{};
+   REQUIRE_THROWS_AS(truncated.get(std::span{actual}), buffer_overflow);
+   REQUIRE(truncated.position() == 0);
+}
+
+TEMPLATE_TEST_CASE_SIG("read_buffer reads consecutive doubles", "[read_buffer]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   std::array<std::byte, 2 * sizeof(double)> buffer{};
+   write_buffer<E> writer{buffer};
+   writer.put(1.5).put(-2.25);
+   read_buffer<E> reader{writer.to_input_buffer()};
+   REQUIRE(static_cast<double>(reader.get()) == 1.5);
+   REQUIRE(static_cast<double>(reader.get()) == -2.25);
+   REQUIRE(reader.remaining() == 0);
+}
+
+TEST_CASE("write_buffer writes varints in LEB128", "[write_buffer]") {
+   std::array<std::byte, 4> buffer{};
+   write_buffer<std::endian::big> writer{buffer};
+   writer.put_varint(std::uint32_t{300}).put_varint(std::int8_t{-1});
+   REQUIRE(writer.position() == 3);
+   REQUIRE(buffer[0] == std::byte{0xac});
+   REQUIRE(buffer[1] == std::byte{0x02});
+   REQUIRE(buffer[2] == std::byte{0x01});
+}
+
+TEMPLATE_TEST_CASE("read_buffer can read varints written by a write_buffer", "[read_buffer,write_buffer]",
+                   std::uint8_t, std::int16_t, std::uint32_t, std::int32_t, std::uint64_t, std::int64_t) {
+   std::vector<TestType> expected;
+   for (auto const x: {0.0, 1.0, -1.0, 63.0, -64.0, 127.0, 128.0, 300.0, 1e5, -1e9, 1e18}) {
+      if (static_cast<double>(std::numeric_limits<TestType>::min()) <= x &&
+          x <= static_cast<double>(std::numeric_limits<TestType>::max())) {
+         expected.push_back(static_cast<TestType>(x));
+      }
+   }
+   expected.push_back(std::numeric_limits<TestType>::min());
+   expected.push_back(std::numeric_limits<TestType>::max());
+   std::array<std::byte, 256> buffer{};
+   write_buffer<std::endian::little> writer{buffer};
+   for (auto const x: expected) {
+      writer.put_varint(x);
+   }
+   read_buffer<std::endian::little> reader{writer.to_input_buffer()};
+   for (auto const x: expected) {
+      REQUIRE(reader.get_varint<TestType>() == x);
+   }
+   REQUIRE(reader.remaining() == 0);
+}
+
+TEST_CASE("read_buffer can read ranges of varints written by a write_buffer", "[read_buffer,write_buffer]") {
+   std::vector<std::int64_t> expected(1000);
+   for (std::size_t i = 0; i < expected.size(); ++i) {
+      // Mostly single-byte values with a longer one every so often
+      expected[i] = 0 == i % 37 ? static_cast<std::int64_t>(i) << (i % 50) : static_cast<std::int64_t>(i % 60) - 30;
+   }
+   std::vector<std::byte> buffer(10 * expected.size());
+   write_buffer<std::endian::little> writer{buffer};
+   writer.put_varint(expected);
+   REQUIRE(writer.position() < 2 * expected.size());
+
+   std::vector<std::int64_t> actual(expected.size());
+   read_buffer<std::endian::little> reader{writer.to_input_buffer()};
+   REQUIRE(reader.get_varint(std::span{actual}) == expected.size());
+   REQUIRE(reader.remaining() == 0);
+   REQUIRE(actual == expected);
+}
+
+TEST_CASE("read_buffer rejects truncated and oversized varints", "[read_buffer]") {
+   std::array<std::byte, 3> buffer{std::byte{0xff}, std::byte{0xff}, std::byte{0x7f}};
+   read_buffer<std::endian::little> truncated{std::span{buffer}.first(2)};
+   REQUIRE_THROWS_AS(truncated.get_varint<std::uint32_t>(), buffer_overflow);
+   read_buffer<std::endian::little> oversized{buffer};
+   REQUIRE_THROWS_AS(oversized.get_varint<std::uint16_t>(), std::out_of_range);
+   REQUIRE(oversized.position() == 0);
+   REQUIRE(oversized.get_varint<std::uint32_t>() == 0x1fffff);
+
+   std::array<std::byte, 3> range{std::byte{2}, std::byte{1}, std::byte{0x80}};
+   std::array<std::uint32_t, 2> values{};
+   read_buffer<std::endian::little> partial{range};
+   REQUIRE_THROWS_AS(partial.get_varint(std::span{values}), buffer_overflow);
+   REQUIRE(partial.position() == 0);
+}
+
+TEST_CASE("write_buffer checks bounds before copying a range of bytes", "[write_buffer]") {
+   std::string const text = "too long";
+   std::array<std::byte, sizeof(std::size_t) + 4> buffer{};
+   write_buffer<std::endian::little> writer{buffer};
+   REQUIRE_THROWS_AS(writer.put(text), buffer_overflow);
+   REQUIRE(writer.position() == 0);
+   REQUIRE(writer.put(std::string_view{text}.substr(0, 4)).remaining() == 0);
+}
+
+TEMPLATE_TEST_CASE_SIG("try_put and try_get report errors without moving the position", "[read_buffer,write_buffer]",
+                       ((std::endian E), E), std::endian::little, std::endian::big) {
+   std::array<std::byte, sizeof(std::uint32_t) + sizeof(double)> buffer{};
+   write_buffer<E> writer{buffer};
+   REQUIRE(writer.try_put(std::uint32_t{7}).has_value());
+   REQUIRE(writer.try_put(std::array<std::int64_t, 1>{-3}).error() == buffer_error::not_enough_space);
+   REQUIRE(writer.position() == sizeof(std::uint32_t));
+   REQUIRE(writer.try_put(2.5).has_value());
+   REQUIRE(writer.try_put(std::uint8_t{1}).error() == buffer_error::not_enough_space);
+   REQUIRE(writer.remaining() == 0);
+
+   read_buffer<E> reader{writer.to_input_buffer()};
+   REQUIRE(reader.template try_get<std::uint32_t>() == 7);
+   REQUIRE(reader.template try_get<std::span<std::byte const> >().error() == buffer_error::not_enough_space);
+   REQUIRE(reader.position() == sizeof(std::uint32_t));
+   REQUIRE(reader.template try_get<double>() == 2.5);
+   REQUIRE(reader.template try_get<float>().error() == buffer_error::not_enough_space);
+}
+
+TEST_CASE("try_get reports ranges that are truncated or do not fit", "[read_buffer]") {
+   std::array<std::uint16_t, 4> const values = {1, 2, 3, 4};
+   std::array<std::byte, sizeof(std::size_t) + sizeof(values)> buffer{};
+   write_buffer<std::endian::big> writer{buffer};
+   REQUIRE(writer.try_put(values).has_value());
+
+   std::array<std::uint16_t, 3> too_small{};
+   read_buffer<std::endian::big> reader{writer.to_input_buffer()};
+   REQUIRE(reader.try_get(std::span{too_small}).error() == buffer_error::out_of_range);
+   read_buffer<std::endian::big> truncated{writer.to_input_buffer(0, buffer.size() - 1)};
+   std::array<std::uint16_t, 4> actual{};
+   REQUIRE(truncated.try_get(std::span{actual}).error() == buffer_error::not_enough_space);
+   REQUIRE(truncated.position() == 0);
+   REQUIRE(reader.try_get(std::span{actual}) == 4);
+   REQUIRE(actual == values);
+
+   std::array<std::byte, 2> varints{std::byte{0x80}, std::byte{0x80}};
+   read_buffer<std::endian::big> partial{varints};
+   REQUIRE(partial.try_get_varint<std::uint64_t>().error() == buffer_error::not_enough_space);
+   REQUIRE(partial.try_get_varint<std::uint8_t>().error() == buffer_error::out_of_range);
+   REQUIRE(partial.position() == 0);
+}
+
+TEMPLATE_TEST_CASE_SIG("reserve and require check bounds once for a group of values", "[read_buffer,write_buffer]",
+                       ((std::endian E), E), std::endian::little, std::endian::big) {
+   std::array<std::uint32_t, 3> const values = {10, 20, 30};
+   constexpr auto size = sizeof(std::int16_t) + sizeof(float) + sizeof(double) + sizeof(std::size_t) + sizeof(values)
+                         + varint_utilities::max_size<std::int64_t>;
+   std::array<std::byte, size> buffer{};
+   write_buffer<E> writer{buffer};
+   REQUIRE_FALSE(writer.try_reserve(size + 1, [](auto &) {
+      FAIL("Reserving more than remains must not run the scope");
+   }).has_value());
+   writer.reserve(size, [&values](auto &w) {
+      w.put(std::int16_t{-2}).put(0.5f).put(-0.25).put(values).put_varint(std::int64_t{-1000});
+   });
+   REQUIRE(writer.position() == size - varint_utilities::max_size<std::int64_t> + 2);
+
+   read_buffer<E> reader{writer.to_input_buffer()};
+   REQUIRE_THROWS_AS(reader.require(writer.position() + 1, [](auto &) {}), buffer_overflow);
+   auto const [a, b, c] = reader.require(sizeof(std::int16_t) + sizeof(float) + sizeof(double), [](auto &r) {
+      auto const x = r.template get<std::int16_t>();
+      auto const y = r.template get<float>();
+      return std::tuple{x, y, r.template get<double>()};
+   });
+   REQUIRE(a == -2);
+   REQUIRE(b == 0.5f);
+   REQUIRE(c == -0.25);
+   std::array<std::uint32_t, 3> actual{};
+   REQUIRE(reader.get(std::span{actual}) == 3);
+   REQUIRE(actual == values);
+   REQUIRE(reader.template get_varint<std::int64_t>() == -1000);
+   REQUIRE(reader.remaining() == 0);
+}
+
+namespace {
+   struct id_entry {
+      std::uint64_t id;
+      std::uint16_t shard;
+      std::int32_t lease;
+   };
+
+   template<std::endian E>
+   struct id_entry_overlay {
+      endian_value<std::uint64_t, E> id;
+      endian_value<std::uint16_t, E> shard;
+      endian_value<std::int32_t, E> lease;
+   };
+}
+
+TEMPLATE_TEST_CASE_SIG("read_buffer overlays records in place", "[read_buffer]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   static_assert(sizeof(id_entry_overlay<E>) == record_utilities::size<id_entry>());
+   std::vector<std::byte> buffer(1 + 100 * sizeof(id_entry_overlay<E>));
+   write_buffer<E> writer{buffer};
+   writer.put(std::uint8_t{0xff});
+   for (std::uint64_t i = 0; i < 100; ++i) {
+      writer.put_record(id_entry{i << 40 | i, static_cast<std::uint16_t>(i % 7), -static_cast<std::int32_t>(i)});
+   }
+
+   read_buffer<E> reader{writer.to_input_buffer(), 1};
+   REQUIRE(reader.template try_overlay<id_entry_overlay<E> >(101).error() == buffer_error::not_enough_space);
+   REQUIRE_THROWS_AS(reader.template overlay<id_entry_overlay<E> >(101), buffer_overflow);
+   REQUIRE(reader.position() == 1);
+   auto const entries = reader.template overlay<id_entry_overlay<E> >(100);
+   REQUIRE(reader.remaining() == 0);
+   REQUIRE(entries[63].id == (std::uint64_t{63} << 40 | 63));
+   REQUIRE(entries[63].shard == 0);
+   REQUIRE(entries[99].lease == -99);
+}
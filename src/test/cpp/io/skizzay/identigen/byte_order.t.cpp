@@ -0,0 +1,42 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/byte_order.h>
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   struct packed_entry {
+      big_endian<std::uint64_t> id;
+      big_endian<std::uint16_t> shard;
+      std::byte flags;
+   };
+}
+
+TEST_CASE("endian_value stores its bytes in the requested order", "[byte_order]") {
+   big_endian<std::uint32_t> const big{0x01020304};
+   little_endian<std::uint32_t> little;
+   little = 0x01020304;
+   std::array<std::byte, 4> bytes{};
+   std::memcpy(bytes.data(), &big, sizeof(big));
+   REQUIRE(bytes == std::array{std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4}});
+   std::memcpy(bytes.data(), &little, sizeof(little));
+   REQUIRE(bytes == std::array{std::byte{4}, std::byte{3}, std::byte{2}, std::byte{1}});
+   REQUIRE(big.value() == 0x01020304);
+   REQUIRE(little == 0x01020304u);
+}
+
+TEST_CASE("endian_value packs without padding", "[byte_order]") {
+   static_assert(1 == alignof(big_endian<std::uint64_t>));
+   static_assert(sizeof(packed_entry) == 11);
+   static_assert(byte_overlay<packed_entry>);
+   static_assert(!byte_overlay<std::uint32_t>);
+   static_assert(big_endian<std::int16_t>{-2}.value() == -2);
+   SUCCEED();
+}
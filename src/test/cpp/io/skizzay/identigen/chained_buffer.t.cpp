@@ -0,0 +1,111 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/chained_buffer.h>
+#include <catch2/catch_all.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   std::vector<std::byte> concatenate(std::vector<std::span<std::byte const> > const &spans) {
+      std::vector<std::byte> result;
+      for (auto const s: spans) {
+         result.insert(result.end(), s.begin(), s.end());
+      }
+      return result;
+   }
+
+   // Writes the same values through any writer with the write_buffer API
+   template<typename Writer>
+   void write_values(Writer &writer) {
+      std::vector<std::uint64_t> ids(100);
+      for (std::size_t i = 0; i < ids.size(); ++i) {
+         ids[i] = i * 0x0102030405060708;
+      }
+      std::vector<std::int16_t> shorts{-1, 2, -3, 4, -5};
+      std::string const text = "chained write buffers never copy";
+      writer.put(std::uint8_t{1}).put(std::int32_t{-7}).put(1.5f).put(-2.25).put(std::uint64_t{42});
+      writer.put(ids).put(shorts).put(text);
+      writer.put_varint(std::int64_t{-300}).put_varint(ids);
+   }
+}
+
+TEMPLATE_TEST_CASE_SIG("chained_write_buffer writes the same bytes as write_buffer", "[chained_write_buffer]",
+                       ((std::endian E), E), std::endian::little, std::endian::big) {
+   std::vector<std::byte> expected(4096);
+   write_buffer<E> flat{expected};
+   write_values(flat);
+   expected.resize(flat.position());
+
+   for (std::size_t const chunk_size: {16u, 17u, 64u, 1000u, 65536u}) {
+      chunk_pool pool{chunk_size};
+      chained_write_buffer<E> chained{pool};
+      write_values(chained);
+      REQUIRE(chained.position() == expected.size());
+      REQUIRE(chained.num_chunks() == (expected.size() + chunk_size - 1) / chunk_size);
+      auto const spans = chained.to_input_buffers();
+      REQUIRE(concatenate(spans) == expected);
+      for (std::size_t i = 0; i + 1 < spans.size(); ++i) {
+         REQUIRE(spans[i].size() == chunk_size);
+      }
+   }
+}
+
+TEST_CASE("chained_write_buffer returns its chunks to the pool", "[chained_write_buffer]") {
+   chunk_pool pool{32, 4};
+   {
+      chained_write_buffer<std::endian::little> writer{pool};
+      for (std::uint64_t i = 0; i < 20; ++i) {
+         writer.put(i);
+      }
+      REQUIRE(writer.num_chunks() == 5);
+   }
+   REQUIRE(pool.num_cached() == 4);
+   {
+      chained_write_buffer<std::endian::little> writer{pool};
+      writer.put(std::uint64_t{1});
+      REQUIRE(pool.num_cached() == 3);
+   }
+   REQUIRE(pool.num_cached() == 4);
+}
+
+TEST_CASE("chained_write_buffer can be handed to another thread with the thread-local pool", "[chained_write_buffer]") {
+   chained_write_buffer<std::endian::big> writer;
+   writer.put(std::uint32_t{0x12345678});
+   std::thread{[moved = std::move(writer)]() mutable {
+      moved.put(std::uint32_t{0x9abcdef0});
+      REQUIRE(moved.position() == 8);
+   }}.join();
+   REQUIRE(writer.position() == 0);
+   REQUIRE(writer.to_input_buffers().empty());
+}
+
+TEST_CASE("chunk_pool rejects chunks too small for a scalar", "[chained_write_buffer]") {
+   REQUIRE_THROWS_AS(chunk_pool{8}, std::invalid_argument);
+}
+
+TEST_CASE("chained_write_buffer refers to referenced payloads instead of copying them", "[chained_write_buffer]") {
+   std::vector<std::byte> payload(1000, std::byte{7});
+   chunk_pool pool{64};
+   chained_write_buffer<std::endian::little> writer{pool};
+   writer.put(std::uint32_t{1}).put_reference(payload).put(std::uint32_t{2});
+   REQUIRE(writer.position() == 4 + 8 + payload.size() + 4);
+   REQUIRE(writer.num_chunks() == 1);
+   auto const spans = writer.to_input_buffers();
+   REQUIRE(spans.size() == 3);
+   REQUIRE(spans[0].size() == 12);
+   REQUIRE(spans[1].data() == payload.data());
+   REQUIRE(spans[1].size() == payload.size());
+   REQUIRE(spans[2].data() == spans[0].data() + 12);
+   REQUIRE(spans[2].size() == 4);
+
+   std::vector<std::byte> expected(writer.position());
+   write_buffer<std::endian::little> flat{expected};
+   flat.put(std::uint32_t{1}).put(payload).put(std::uint32_t{2});
+   REQUIRE(concatenate(spans) == expected);
+}
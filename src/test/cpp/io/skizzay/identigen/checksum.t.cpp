@@ -0,0 +1,190 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/checksum.h>
+#include <io/skizzay/identigen/chained_buffer.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+static_assert(checksum<crc32c>);
+static_assert(checksum<xxh3>);
+
+namespace {
+   std::vector<std::byte> pattern(std::size_t const n) {
+      std::vector<std::byte> result(n);
+      for (std::size_t i = 0; i < n; ++i) {
+         result[i] = static_cast<std::byte>(i * 7 + 3);
+      }
+      return result;
+   }
+
+   std::span<std::byte const> bytes_of(std::string_view const s) {
+      return std::as_bytes(std::span{s});
+   }
+
+   // One bit at a time, straight from the definition
+   std::uint32_t reference_crc32c(std::span<std::byte const> const bytes) {
+      std::uint32_t crc = ~std::uint32_t{};
+      for (auto const b: bytes) {
+         crc ^= static_cast<std::uint8_t>(b);
+         for (int bit = 0; bit < 8; ++bit) {
+            crc = 0 == (crc & 1) ? crc >> 1 : (crc >> 1) ^ 0x82f63b78;
+         }
+      }
+      return ~crc;
+   }
+
+   // Feeds bytes in pieces of the given size, cycling through them
+   template<checksum C>
+   typename C::value_type in_pieces(std::span<std::byte const> bytes, std::vector<std::size_t> const &sizes) {
+      C result;
+      for (std::size_t i = 0; !bytes.empty(); ++i) {
+         auto const n = std::min(sizes[i % sizes.size()], bytes.size());
+         result.update(bytes.first(n));
+         bytes = bytes.subspan(n);
+      }
+      return result.value();
+   }
+}
+
+TEST_CASE("crc32c matches the standard check values", "[checksum]") {
+   REQUIRE(crc32c::compute({}) == 0);
+   REQUIRE(crc32c::compute(bytes_of("123456789")) == 0xe3069283);
+   std::vector<std::byte> const zeros(32);
+   REQUIRE(crc32c::compute(zeros) == 0x8a9136aa);
+   std::vector<std::byte> const ones(32, std::byte{0xff});
+   REQUIRE(crc32c::compute(ones) == 0x62a8ab43);
+}
+
+TEST_CASE("crc32c matches the bitwise definition at every size", "[checksum]") {
+   // Covers the tail, the short three-stream blocks and the long ones, with and without a remainder
+   auto const n = GENERATE(as<std::size_t>{}, 1, 7, 8, 9, 767, 768, 769, 2000, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 777,
+                           100000);
+   auto const bytes = pattern(n);
+   REQUIRE(crc32c::compute(bytes) == reference_crc32c(bytes));
+}
+
+TEST_CASE("crc32c gives the same value however the bytes are split", "[checksum]") {
+   auto const bytes = pattern(60000);
+   auto const expected = crc32c::compute(bytes);
+   auto const sizes = GENERATE(std::vector<std::size_t>{1}, std::vector<std::size_t>{3, 5, 7},
+                               std::vector<std::size_t>{1000, 1}, std::vector<std::size_t>{25000});
+   REQUIRE(in_pieces<crc32c>(bytes, sizes) == expected);
+}
+
+TEST_CASE("xxh3 matches the reference implementation", "[checksum]") {
+   REQUIRE(xxh3::compute({}) == 0x2d06800538d394c2);
+   REQUIRE(xxh3::compute(bytes_of("a")) == 0xe6c632b61e964e1f);
+   REQUIRE(xxh3::compute(bytes_of("abc")) == 0x78af5f94892f3950);
+   REQUIRE(xxh3::compute(bytes_of("0123456789abcdef")) == 0x64439946d8fa212d);
+
+   // One size from each length class, and either side of every boundary between them
+   auto const [n, expected] = GENERATE(table<std::size_t, std::uint64_t>({
+      {1, 0x13e608bc156defed}, {3, 0xa9088dda485b481c}, {4, 0x6d9253b16c8b1ed3}, {8, 0x60539db630471163},
+      {9, 0xfeff668361d723a8}, {16, 0xb8c859b0f030b585}, {17, 0x714a04408e79b80f}, {100, 0xb5937857f0d78c9f},
+      {128, 0x67425a03650261bf}, {129, 0xc664bf3311c6abc4}, {200, 0x746cd0025327bf5b}, {240, 0x64556dc6b462a6cf},
+      {241, 0x8beadd3a8874fe17}, {256, 0x3c38817f6d79c0da}, {257, 0x2a300c3495738ea6}, {1024, 0x9b81661c641c72b1},
+      {1025, 0x806c2072ed713576}, {2048, 0xabe604813ba62ed1}, {4000, 0xb64c496535c38eb6}
+   }));
+   auto const bytes = pattern(n);
+   REQUIRE(xxh3::compute(bytes) == expected);
+   REQUIRE(xxh3{}.update(bytes).value() == expected);
+}
+
+TEST_CASE("xxh3 gives the same value however the bytes are split", "[checksum]") {
+   auto const n = GENERATE(as<std::size_t>{}, 200, 241, 256, 300, 1024, 1279, 1280, 5000);
+   auto const bytes = pattern(n);
+   auto const expected = xxh3::compute(bytes);
+   auto const sizes = GENERATE(std::vector<std::size_t>{1}, std::vector<std::size_t>{3, 64, 7},
+                               std::vector<std::size_t>{256}, std::vector<std::size_t>{255, 513},
+                               std::vector<std::size_t>{1000});
+   REQUIRE(in_pieces<xxh3>(bytes, sizes) == expected);
+}
+
+TEMPLATE_TEST_CASE_SIG("write_checksum follows what a write_buffer writes", "[checksum]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   std::vector<std::byte> buffer(1024);
+   write_buffer<E> writer{buffer};
+   writer.put(std::uint8_t{7});
+   write_checksum<crc32c, E> crc{writer};
+   write_checksum<xxh3, E> hash{writer};
+
+   writer.put(std::uint64_t{42}).put(std::string_view{"batch"});
+   crc.update();
+   auto sub = writer.subwriter();
+   sub.put(std::int32_t{-1}).put_varint(300u);
+   hash.update();
+   writer.position(writer.position() + sub.position());
+   auto const end = writer.position();
+
+   auto const payload = writer.to_input_buffer(1);
+   REQUIRE(crc.value() == crc32c::compute(payload));
+   REQUIRE(hash.value() == xxh3::compute(payload));
+
+   crc.put(writer);
+   REQUIRE(static_cast<std::uint32_t>(read_buffer<E>{writer.to_input_buffer(end)}.get()) == crc32c::compute(payload));
+   REQUIRE(writer.position() == end + sizeof(std::uint32_t));
+}
+
+TEMPLATE_TEST_CASE_SIG("read_checksum verifies what write_checksum put", "[checksum]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   std::vector<std::byte> buffer(1024);
+   write_buffer<E> writer{buffer};
+   write_checksum<xxh3, E> written{writer};
+   writer.put(std::uint16_t{513}).put(std::vector<std::uint32_t>{1, 2, 3});
+   written.put(writer);
+   writer.put(std::uint64_t{99});
+   written.put(writer);
+   auto const size = writer.position();
+
+   SECTION("intact frames verify") {
+      read_buffer<E> reader{writer.to_input_buffer()};
+      read_checksum<xxh3, E> read{reader};
+      REQUIRE(static_cast<std::uint16_t>(reader.get()) == 513);
+      read.update();
+      std::vector<std::uint32_t> values(3);
+      reader.get(std::span{values});
+      REQUIRE_NOTHROW(read.verify(reader));
+      REQUIRE(static_cast<std::uint64_t>(reader.get()) == 99);
+      REQUIRE_NOTHROW(read.verify(reader));
+      REQUIRE(reader.position() == size);
+   }
+
+   SECTION("a flipped bit is caught") {
+      buffer[14] ^= std::byte{0x10};
+      read_buffer<E> reader{std::span<std::byte const>{buffer}.first(size)};
+      read_checksum<xxh3, E> read{reader};
+      static_cast<void>(static_cast<std::uint16_t>(reader.get()));
+      std::vector<std::uint32_t> values(3);
+      reader.get(std::span{values});
+      REQUIRE_THROWS_AS(read.verify(reader), checksum_mismatch);
+   }
+}
+
+TEST_CASE("checksums run over the spans of a chained_write_buffer", "[checksum]") {
+   chunk_pool pool{64};
+   chained_write_buffer<std::endian::little> writer{pool};
+   auto const payload = pattern(1000);
+   writer.put(payload).put(std::uint32_t{17});
+
+   std::vector<std::byte> flat;
+   crc32c crc;
+   xxh3 hash;
+   for (auto const bytes: writer.to_input_buffers()) {
+      crc.update(bytes);
+      hash.update(bytes);
+      flat.insert(flat.end(), bytes.begin(), bytes.end());
+   }
+   REQUIRE(1 < writer.to_input_buffers().size());
+   REQUIRE(crc.value() == crc32c::compute(flat));
+   REQUIRE(hash.value() == xxh3::compute(flat));
+}
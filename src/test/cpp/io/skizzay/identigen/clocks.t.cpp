@@ -0,0 +1,111 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/clocks.h>
+#include <io/skizzay/identigen/generator.h>
+#include <catch2/catch_all.hpp>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   // The system clock, stepped back an hour after its first read
+   struct stepped_clock final {
+      using rep = std::chrono::system_clock::rep;
+      using period = std::chrono::system_clock::period;
+      using duration = std::chrono::system_clock::duration;
+      using time_point = std::chrono::time_point<stepped_clock>;
+      static constexpr bool is_steady = false;
+
+      static time_point now() noexcept {
+         static std::atomic<int> reads{0};
+         auto const step = 0 == reads++ ? duration{} : std::chrono::duration_cast<duration>(std::chrono::hours{1});
+         return time_point{std::chrono::system_clock::now().time_since_epoch() - step};
+      }
+   };
+}
+
+TEST_CASE("ticker_clock is a timestamp_provider", "[clocks]") {
+   REQUIRE(timestamp_provider<ticker_clock<> >);
+   REQUIRE(timestamp_provider<std::reference_wrapper<ticker_clock<> > >);
+}
+
+TEST_CASE("ticker_clock follows the system clock", "[clocks]") {
+   using namespace std::chrono;
+   ticker_clock<system_clock, milliseconds> const target{microseconds{100}};
+   auto const before = floor<milliseconds>(system_clock::now());
+   std::this_thread::sleep_for(milliseconds{20});
+   auto const actual = target();
+   auto const after = floor<milliseconds>(system_clock::now());
+   REQUIRE(before < actual);
+   REQUIRE(actual <= after);
+}
+
+TEST_CASE("tsc_clock is a timestamp_provider", "[clocks]") {
+   REQUIRE(timestamp_provider<tsc_clock<> >);
+   REQUIRE(timestamp_provider<std::reference_wrapper<tsc_clock<> > >);
+}
+
+TEST_CASE("tsc_clock stays close to the system clock", "[clocks]") {
+   using namespace std::chrono;
+   tsc_clock<system_clock, microseconds> const target{milliseconds{5}, milliseconds{10}};
+   REQUIRE(0 < target.frequency());
+   for (int i = 0; i < 5; ++i) {
+      std::this_thread::sleep_for(milliseconds{7});
+      auto const expected = system_clock::now();
+      auto const actual = target();
+      REQUIRE(abs(duration_cast<microseconds>(actual - expected)) < milliseconds{5});
+   }
+}
+
+TEST_CASE("tsc_clock calibrates its rate undisturbed by a step of its clock", "[clocks]") {
+   using namespace std::chrono;
+   tsc_clock<system_clock, microseconds> const reference{milliseconds{20}};
+   tsc_clock<stepped_clock, microseconds> const target{milliseconds{20}};
+   REQUIRE(abs(target.frequency() - reference.frequency()) < reference.frequency() / 20);
+   auto const expected = system_clock::now().time_since_epoch() - hours{1};
+   REQUIRE(abs(duration_cast<microseconds>(target().time_since_epoch() - expected)) < milliseconds{5});
+}
+
+TEST_CASE("cached clocks stop their threads without waiting out the period", "[clocks]") {
+   using namespace std::chrono;
+   auto const start = steady_clock::now();
+   {
+      ticker_clock<system_clock, milliseconds> const ticker{seconds{10}};
+      tsc_clock<system_clock, microseconds> const tsc{milliseconds{1}, seconds{10}};
+   }
+   REQUIRE(steady_clock::now() - start < seconds{5});
+}
+
+TEST_CASE("cached clocks can drive a generator", "[clocks]") {
+   using namespace std::chrono;
+   ticker_clock<system_clock, milliseconds> clock;
+   auto const epoch = sys_days{year{2020} / January / 1};
+   generator target{std::ref(clock), 12,
+                    value_provider_utilities::from_timestamp(time_point_cast<milliseconds>(epoch), milliseconds{1LL << 41})};
+   auto const first = target.next();
+   auto const second = target.next();
+   REQUIRE(first < second);
+}
+
+TEST_CASE("hybrid_logical_clock never moves backwards", "[clocks]") {
+   using namespace std::chrono;
+   std::atomic<std::int64_t> now{100};
+   hybrid_logical_clock target{[&now] { return sys_time<milliseconds>{milliseconds{now.load()}}; }};
+   REQUIRE(timestamp_provider<decltype(target) &>);
+   REQUIRE(target().time_since_epoch() == milliseconds{100});
+   now = 50;
+   REQUIRE(target().time_since_epoch() == milliseconds{100});
+   now = 150;
+   REQUIRE(target().time_since_epoch() == milliseconds{150});
+}
+
+TEST_CASE("hybrid_logical_clock orders after observed timestamps", "[clocks]") {
+   using namespace std::chrono;
+   std::atomic<std::int64_t> now{100};
+   hybrid_logical_clock target{[&now] { return sys_time<milliseconds>{milliseconds{now.load()}}; }};
+   target.observe(sys_time<milliseconds>{milliseconds{500}});
+   REQUIRE(target().time_since_epoch() == milliseconds{500});
+   target.observe(sys_time<milliseconds>{milliseconds{200}});
+   REQUIRE(target().time_since_epoch() == milliseconds{500});
+}
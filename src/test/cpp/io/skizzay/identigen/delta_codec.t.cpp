@@ -0,0 +1,111 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/delta_codec.h>
+#include <catch2/catch_all.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   // IDs with a millisecond timestamp above a 22-bit sequence, arriving slightly out of order
+   std::vector<std::uint64_t> nearly_sorted_ids(std::size_t const n) {
+      std::mt19937_64 random{42};
+      std::vector<std::uint64_t> result(n);
+      std::uint64_t timestamp = 1'700'000'000'000;
+      for (std::size_t i = 0; i < n; ++i) {
+         timestamp += random() % 3;
+         result[i] = (timestamp << 22) | (random() % 64);
+      }
+      for (std::size_t i = 1; i < n; i += 7) {
+         std::swap(result[i - 1], result[i]);
+      }
+      return result;
+   }
+
+   template<std::endian E>
+   std::vector<std::uint64_t> round_trip(std::vector<std::uint64_t> const &ids, std::size_t *const encoded_size = nullptr) {
+      std::vector<std::byte> buffer(2048 + ids.size() * 9);
+      write_buffer<E> writer{buffer};
+      delta_codec::encode(writer, std::span<std::uint64_t const>{ids});
+      if (nullptr != encoded_size) {
+         *encoded_size = writer.position();
+      }
+      read_buffer<E> reader{writer.to_input_buffer()};
+      std::vector<std::uint64_t> result(ids.size());
+      REQUIRE(delta_codec::decode(reader, std::span{result}) == ids.size());
+      REQUIRE(reader.remaining() == 0);
+      return result;
+   }
+}
+
+TEMPLATE_TEST_CASE_SIG("delta_codec round-trips IDs", "[delta_codec]", ((std::endian E), E), std::endian::little,
+                       std::endian::big) {
+   for (std::size_t const n: {0u, 1u, 5u, 127u, 128u, 129u, 1000u}) {
+      auto const ids = nearly_sorted_ids(n);
+      REQUIRE(round_trip<E>(ids) == ids);
+   }
+}
+
+TEST_CASE("delta_codec round-trips IDs needing every bit", "[delta_codec]") {
+   std::mt19937_64 random{7};
+   std::vector<std::uint64_t> ids(300);
+   for (auto &id: ids) {
+      id = random();
+   }
+   ids[3] = 0;
+   ids[4] = ~std::uint64_t{};
+   REQUIRE(round_trip<std::endian::little>(ids) == ids);
+}
+
+TEST_CASE("delta_codec compresses nearly sorted IDs", "[delta_codec]") {
+   auto const ids = nearly_sorted_ids(128 * 100);
+   std::size_t encoded_size = 0;
+   REQUIRE(round_trip<std::endian::little>(ids, &encoded_size) == ids);
+   REQUIRE(encoded_size < ids.size() * sizeof(std::uint64_t) / 2);
+}
+
+TEST_CASE("delta_block_view decodes any block on its own", "[delta_codec]") {
+   auto const ids = nearly_sorted_ids(1000);
+   std::vector<std::byte> buffer(10000);
+   write_buffer<std::endian::big> writer{buffer};
+   delta_codec::encode(writer, std::span<std::uint64_t const>{ids});
+   read_buffer<std::endian::big> reader{writer.to_input_buffer()};
+   delta_block_view const view{reader};
+   REQUIRE(view.size() == 1000);
+   REQUIRE(view.num_blocks() == 8);
+   std::vector<std::uint64_t> block(delta_codec::block_size);
+   REQUIRE(view.block(7, std::span{block}) == 1000 - 7 * delta_codec::block_size);
+   REQUIRE(std::equal(ids.begin() + 7 * delta_codec::block_size, ids.end(), block.begin()));
+   REQUIRE(view.block(3, std::span{block}) == delta_codec::block_size);
+   REQUIRE(std::equal(block.begin(), block.end(), ids.begin() + 3 * delta_codec::block_size));
+   REQUIRE_THROWS_AS(view.block(8, std::span{block}), std::out_of_range);
+}
+
+TEST_CASE("delta_codec does not write when the IDs do not fit", "[delta_codec]") {
+   auto const ids = nearly_sorted_ids(200);
+   std::vector<std::byte> buffer(100);
+   write_buffer<std::endian::little> writer{buffer};
+   REQUIRE_THROWS_AS(delta_codec::encode(writer, std::span<std::uint64_t const>{ids}), buffer_overflow);
+   REQUIRE(writer.position() == 0);
+}
+
+TEST_CASE("delta_block_view checks the block index before allocating for it", "[delta_codec]") {
+   std::vector<std::byte> buffer(64);
+   write_buffer<std::endian::little> writer{buffer};
+   std::size_t const size = std::size_t{1} << 40;
+   writer.put_varint(size);
+   writer.put(size / delta_codec::block_size);
+   read_buffer<std::endian::little> reader{writer.to_input_buffer()};
+   REQUIRE_THROWS_AS(delta_block_view{reader}, buffer_overflow);
+   REQUIRE(reader.position() == 0);
+
+   write_buffer<std::endian::little> mismatched{buffer};
+   mismatched.put_varint(size);
+   mismatched.put(std::size_t{1});
+   read_buffer<std::endian::little> mismatched_reader{mismatched.to_input_buffer()};
+   REQUIRE_THROWS_AS(delta_block_view{mismatched_reader}, std::out_of_range);
+}
@@ -0,0 +1,292 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/generator.h>
+#include <io/skizzay/identigen/clocks.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+
+namespace {
+   using namespace std::chrono;
+
+   // Advances by one millisecond on every read, so a generator can never exhaust its sequence without moving on.
+   struct ticking_clock final {
+      std::atomic<std::int64_t> *now;
+
+      sys_time<milliseconds> operator()() const noexcept {
+         return sys_time<milliseconds>{milliseconds{now->fetch_add(1)}};
+      }
+   };
+
+   // Key counting how many times std::hash hashes it
+   struct counted_key final {
+      static inline int hashes = 0;
+
+      int value;
+
+      friend bool operator==(counted_key, counted_key) = default;
+   };
+}
+
+template<>
+struct std::hash<counted_key> {
+   std::size_t operator()(counted_key const k) const noexcept {
+      ++counted_key::hashes;
+      return std::hash<int>{}(k.value);
+   }
+};
+
+TEST_CASE("generator packs providers and sequence into an ID", "[generator]") {
+   std::atomic<std::int64_t> now{1000};
+   generator target{manual_clock{&now}, 4, value_provider_utilities::from_constant(5),
+                    value_provider_utilities::partitioned(8)};
+   REQUIRE(target.num_sequence_bits() == 4);
+   REQUIRE(target.num_significant_bits() == 3 + 3 + 4);
+   REQUIRE(target.next(3) == ((5u << 7) | (3u << 4) | 0u));
+   REQUIRE(target.next(3) == ((5u << 7) | (3u << 4) | 1u));
+   REQUIRE(target.next(6) == ((5u << 7) | (6u << 4) | 2u));
+}
+
+TEST_CASE("generator hashes a hashed_key once for every provider", "[generator]") {
+   struct counting_hash final {
+      int *count;
+
+      std::size_t operator()(std::string_view const k) const noexcept {
+         ++*count;
+         return key_hash{}(k);
+      }
+   };
+
+   std::atomic<std::int64_t> now{1000};
+   generator target{manual_clock{&now}, 4, value_provider_utilities::partitioned(8),
+                    value_provider_utilities::partitioned_uniform(16, key_hash{}),
+                    value_provider_utilities::partitioned_consistent(4)};
+   int count = 0;
+   hashed_key const k{"tenant-42", counting_hash{&count}};
+   auto const id = target.next(k);
+   REQUIRE(count == 1);
+   REQUIRE(id >> 4 == target.next(hashed_key{"tenant-42"}) >> 4);
+   REQUIRE(id >> 4 == target.next(hashed_key{std::string{"tenant-42"}}) >> 4);
+}
+
+TEST_CASE("generator hashes a default hashed_key once under default partitionings", "[generator]") {
+   std::atomic<std::int64_t> now{1000};
+   generator target{manual_clock{&now}, 4, value_provider_utilities::partitioned(8),
+                    value_provider_utilities::partitioned_uniform(16),
+                    value_provider_utilities::partitioned_consistent(4)};
+   counted_key::hashes = 0;
+   hashed_key const k{counted_key{42}};
+   auto const id = target.next(k);
+   REQUIRE(counted_key::hashes == 1);
+   REQUIRE(id >> 4 == target.next(counted_key{42}) >> 4);
+}
+
+TEST_CASE("generator replaced to resize a consistent partitioning issues no duplicates", "[generator]") {
+   std::atomic<std::int64_t> now{1000};
+   auto const epoch = sys_time<milliseconds>{};
+   std::vector<std::uint64_t> ids;
+   generator old{manual_clock{&now}, 4, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20}),
+                 value_provider_utilities::partitioned_consistent(4, 8)};
+   for (std::uint64_t k = 0; k < 12; ++k) {
+      ids.push_back(old.next(k));
+   }
+
+   generator resized{manual_clock{&now}, 4, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20}),
+                     value_provider_utilities::partitioned_consistent(5, 8)};
+   REQUIRE(resized.num_significant_bits() == old.num_significant_bits());
+   resized.fast_forward(old.high_water_mark());
+   for (std::uint64_t k = 0; k < 12; ++k) {
+      ids.push_back(resized.next(k));
+   }
+   std::ranges::sort(ids);
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
+
+TEST_CASE("generator resets the sequence when the clock moves on", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{manual_clock{&now}, 8, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 10})};
+   REQUIRE(target.next() == 0);
+   REQUIRE(target.next() == 1);
+   now = 3;
+   REQUIRE(target.next() == ((3u << 8) | 0u));
+   REQUIRE(target.next() == ((3u << 8) | 1u));
+}
+
+TEST_CASE("generator waits for the next tick when the sequence is exhausted", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{ticking_clock{&now}, 1, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   std::vector<std::uint64_t> ids(64);
+   std::ranges::generate(ids, [&target] { return target.next(); });
+   REQUIRE(std::ranges::is_sorted(ids));
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
+
+TEST_CASE("generator rejects layouts wider than 64 bits", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   REQUIRE_THROWS_AS((generator{manual_clock{&now}, 60, value_provider_utilities::from_constant(0xff)}),
+                     std::invalid_argument);
+   REQUIRE_THROWS_AS((generator{manual_clock{&now}, 64}), std::invalid_argument);
+}
+
+TEST_CASE("generator produces unique IDs across threads", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{ticking_clock{&now}, 12, value_provider_utilities::from_timestamp(epoch, milliseconds{1LL << 40})};
+   constexpr std::size_t num_threads = 4;
+   constexpr std::size_t num_ids = 10'000;
+   std::vector<std::vector<std::uint64_t> > ids(num_threads);
+   {
+      std::vector<std::jthread> threads;
+      for (auto &thread_ids: ids) {
+         threads.emplace_back([&target, &thread_ids] {
+            thread_ids.resize(num_ids);
+            std::ranges::generate(thread_ids, [&target] { return target.next(); });
+         });
+      }
+   }
+   std::vector<std::uint64_t> all;
+   for (auto const &thread_ids: ids) {
+      all.insert(all.end(), thread_ids.begin(), thread_ids.end());
+   }
+   std::ranges::sort(all);
+   REQUIRE(std::ranges::adjacent_find(all) == all.end());
+}
+
+TEST_CASE("basic_generator packs IDs with a compile-time layout", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   basic_generator target{id_layout<20, 4, 8>{}, manual_clock{&now},
+                          value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20}),
+                          value_provider_utilities::from_constant(9)};
+   REQUIRE(target.num_sequence_bits() == 8);
+   REQUIRE(target.num_significant_bits() == 32);
+   now = 17;
+   auto const id = target.next();
+   REQUIRE(id == id_layout<20, 4, 8>::pack({17, 9, 0}));
+   REQUIRE(target.layout().decode<0>(target.next()) == 17);
+}
+
+TEST_CASE("basic_generator rejects providers wider than their layout field", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   REQUIRE_THROWS_AS((basic_generator{id_layout<4, 8>{}, manual_clock{&now}, value_provider_utilities::from_constant(0xff)}),
+                     std::invalid_argument);
+}
+
+TEST_CASE("generator fills a span with consecutive IDs", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{manual_clock{&now}, 10, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20}),
+                    value_provider_utilities::partitioned(16)};
+   std::vector<std::uint64_t> ids(100);
+   target.generate_n(ids, 5);
+   for (std::size_t i = 0; i < ids.size(); ++i) {
+      REQUIRE(ids[i] == target.layout().pack({0, 5, i}));
+   }
+   REQUIRE(target.next(5) == target.layout().pack({0, 5, 100}));
+}
+
+TEST_CASE("generator fills a span across ticks when the sequence is exhausted", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{ticking_clock{&now}, 4, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   std::vector<std::uint64_t> ids(1000);
+   target.generate_n(ids, 0);
+   REQUIRE(std::ranges::is_sorted(ids));
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
+
+TEST_CASE("generator fills a span with an ID for each key", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   generator target{manual_clock{&now}, 8, value_provider_utilities::partitioned(16)};
+   std::vector<int> const keys{3, 1, 4, 1, 5, 9, 2, 6};
+   std::vector<std::uint64_t> ids(keys.size());
+   target.generate_n(ids, std::span{keys});
+   for (std::size_t i = 0; i < ids.size(); ++i) {
+      REQUIRE(ids[i] == target.layout().pack({static_cast<std::uint64_t>(keys[i]), i}));
+   }
+   std::vector<std::uint64_t> too_many(keys.size() + 1);
+   REQUIRE_THROWS_AS(target.generate_n(too_many, std::span{keys}), std::invalid_argument);
+}
+
+TEST_CASE("generator throws when the clock is further behind than the spin policy allows", "[generator]") {
+   std::atomic<std::int64_t> now{100};
+   generator target{clock_regression_policy::spin(milliseconds{10}), manual_clock{&now}, 8,
+                    value_provider_utilities::from_timestamp(sys_time<milliseconds>{}, milliseconds{1 << 20})};
+   REQUIRE(target.next() == 100u << 8);
+   now = 80;
+   REQUIRE_THROWS_AS(target.next(), clock_regression);
+   now = 200;
+   REQUIRE(target.next() == 200u << 8);
+   now = 150;
+   REQUIRE_THROWS_AS(target.next(), clock_regression);
+}
+
+TEST_CASE("generator keeps going once the ticks since its origin outgrow the bits the sequence leaves", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   // 40 sequence bits leave 24 for the tick, which wrap after 2^24 ms
+   generator target{clock_regression_policy::spin(milliseconds{2}), manual_clock{&now}, 40,
+                    value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 23})};
+   auto const wrap = std::int64_t{1} << 24;
+   for (auto const t: {wrap - 1, wrap, wrap + 1, 3 * wrap + 7}) {
+      now = t;
+      auto const first = target.next();
+      REQUIRE(target.layout().decode<1>(first) == 0);
+      REQUIRE(target.layout().decode<0>(first) == static_cast<std::uint64_t>(t % (1 << 23)));
+      REQUIRE(target.layout().decode<1>(target.next()) == 1);
+      REQUIRE(target.high_water_mark() == sys_time<milliseconds>{milliseconds{t}});
+   }
+   now = 3 * wrap + 7 - 5;
+   REQUIRE_THROWS_AS(target.next(), clock_regression);
+}
+
+TEST_CASE("generator borrows from future ticks while the clock is behind", "[generator]") {
+   std::atomic<std::int64_t> now{0};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{clock_regression_policy::borrow(milliseconds{2}, milliseconds{0}), manual_clock{&now}, 1,
+                    value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   std::vector<std::uint64_t> ids(6);
+   std::ranges::generate(ids, [&target] { return target.next(); });
+   REQUIRE(ids == std::vector<std::uint64_t>{0, 1, 2, 3, 4, 5});
+   REQUIRE_THROWS_AS(target.next(), clock_regression);
+   now = 1;
+   REQUIRE(target.next() == 6);
+}
+
+TEST_CASE("generator fast-forwarded past the current tick carries on without waiting", "[generator]") {
+   std::atomic<std::int64_t> now{5};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{manual_clock{&now}, 1, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   target.fast_forward(target.now());
+   REQUIRE(target.try_next(0).has_value());
+   REQUIRE(target.high_water_mark() == sys_time<milliseconds>{milliseconds{6}});
+}
+
+TEST_CASE("generator borrows across a clock step when driven by a hybrid logical clock", "[generator]") {
+   std::atomic<std::int64_t> now{1000};
+   auto const epoch = sys_time<milliseconds>{};
+   hybrid_logical_clock hlc{manual_clock{&now}};
+   generator target{clock_regression_policy::borrow(nanoseconds::max(), milliseconds{0}), std::ref(hlc), 2,
+                    value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   std::vector<std::uint64_t> ids(8);
+   target.generate_n(ids, 0);
+   now = 10;
+   std::ranges::generate(ids, [&target] { return target.next(); });
+   REQUIRE(target.layout().decode<0>(ids.back()) == 1003);
+   hlc.observe(sys_time<milliseconds>{milliseconds{2000}});
+   REQUIRE(target.layout().decode<0>(target.next()) == 2000);
+   REQUIRE(std::ranges::is_sorted(ids));
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
@@ -0,0 +1,190 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/hash.h>
+#include <io/skizzay/identigen/hash_combine.h>
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   enum class color : std::uint8_t {
+      red,
+      green
+   };
+
+   struct tenant_key final {
+      std::string tenant;
+      std::uint32_t region;
+
+      bool operator==(tenant_key const &) const = default;
+   };
+
+   struct unhashable final {
+      bool operator==(unhashable const &) const = default;
+   };
+}
+
+template<>
+struct std::hash<tenant_key> {
+   std::size_t operator()(tenant_key const &k) const noexcept {
+      return hash_combine(key_hash{}(k.tenant), key_hash{}(k.region));
+   }
+};
+
+static_assert(key<std::uint64_t, key_hash>);
+static_assert(key<std::string, key_hash>);
+static_assert(key<std::pair<std::string, int>, key_hash>);
+static_assert(key<std::vector<std::tuple<int, double> >, key_hash>);
+static_assert(key<tenant_key, key_hash>);
+static_assert(!key<unhashable, key_hash>);
+static_assert(key<int, standard_hash>);
+
+TEST_CASE("key_hash mixes integers", "[hash]") {
+   key_hash const h;
+   REQUIRE(h(std::uint64_t{1}) != 1);
+   REQUIRE(h(std::uint64_t{1}) != h(std::uint64_t{2}));
+   REQUIRE(h(std::int32_t{-5}) == h(std::int64_t{-5}));
+   REQUIRE(h(std::uint8_t{7}) == h(7ull));
+   REQUIRE(h(color::green) == h(1));
+   REQUIRE(h(0.0) == h(-0.0));
+   REQUIRE(h(1.5f) == h(1.5));
+   REQUIRE(h(1.5) != h(2.5));
+}
+
+TEST_CASE("key_hash avalanches", "[hash]") {
+   // Flipping any one input bit flips each output bit about half the time
+   key_hash const h;
+   std::mt19937_64 random{11};
+   std::array<std::array<int, 64>, 64> flips = {};
+   constexpr int trials = 2000;
+   for (int t = 0; t < trials; ++t) {
+      auto const x = random();
+      auto const hx = h(x);
+      for (int in = 0; in < 64; ++in) {
+         auto const changed = hx ^ h(x ^ (std::uint64_t{1} << in));
+         for (int out = 0; out < 64; ++out) {
+            flips[in][out] += static_cast<int>((changed >> out) & 1);
+         }
+      }
+   }
+   for (auto const &row: flips) {
+      for (auto const n: row) {
+         REQUIRE(std::abs(n - trials / 2) < trials / 10);
+      }
+   }
+}
+
+TEST_CASE("key_hash hashes strings by their characters", "[hash]") {
+   key_hash const h;
+   std::string const s = "tenant-42";
+   REQUIRE(h(s) == h(std::string_view{s}));
+   REQUIRE(h(s) == h("tenant-42"));
+   REQUIRE(h(s) == h(s.c_str()));
+   REQUIRE(h(s) == xxh3::compute(std::as_bytes(std::span{s})));
+   REQUIRE(h(s) != h(std::string{"tenant-43"}));
+   REQUIRE(h(std::string{}) == h(""));
+}
+
+TEST_CASE("key_hash combines the elements of composite keys", "[hash]") {
+   key_hash const h;
+   REQUIRE(h(std::pair{std::string{"a"}, 1}) == h(std::tuple{std::string_view{"a"}, 1}));
+   REQUIRE(h(std::pair{1, 2}) != h(std::pair{2, 1}));
+   REQUIRE(h(std::vector<std::string>{"ab", "c"}) != h(std::vector<std::string>{"a", "bc"}));
+   REQUIRE(h(std::vector{1, 2, 3}) == h(std::array{1, 2, 3}));
+   REQUIRE(h(tenant_key{"acme", 3}) == hash_utilities::mix(std::hash<tenant_key>{}(tenant_key{"acme", 3})));
+   REQUIRE(hash_utilities::combine(1, 2, std::uint64_t{3}) == hash_combine(1, 2, std::size_t{3}));
+}
+
+TEST_CASE("key_hash spreads sequential keys over buckets evenly", "[hash]") {
+   constexpr std::size_t num_buckets = 16;
+   constexpr std::size_t num_keys = 160000;
+   key_hash const h;
+   for (std::uint64_t const stride: {1, 16, 4096}) {
+      std::array<std::size_t, num_buckets> counts = {};
+      for (std::uint64_t i = 0; i < num_keys; ++i) {
+         ++counts[h(i * stride) % num_buckets];
+      }
+      auto const [least, most] = std::ranges::minmax(counts);
+      REQUIRE(static_cast<double>(most) / static_cast<double>(least) < 1.1);
+   }
+}
+
+TEST_CASE("hash_utilities hashes batches of keys", "[hash]") {
+   key_hash const h;
+   SECTION("integers") {
+      std::vector<std::uint64_t> keys(37);
+      std::mt19937_64 random{5};
+      for (auto &k: keys) {
+         k = random();
+      }
+      std::vector<std::size_t> hashes(keys.size() + 1, 0);
+      hash_utilities::hash(std::span<std::uint64_t const>{keys}, std::span{hashes});
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+         REQUIRE(hashes[i] == h(keys[i]));
+      }
+      REQUIRE(hashes.back() == 0);
+   }
+
+   SECTION("strings and other hashes") {
+      std::vector<std::string> const keys = {"a", "bb", "ccc"};
+      std::array<std::size_t, 3> hashes = {};
+      hash_utilities::hash(std::span<std::string const>{keys}, std::span{hashes});
+      REQUIRE(hashes[2] == h(keys[2]));
+      hash_utilities::hash(std::span<std::string const>{keys}, std::span{hashes}, standard_hash{});
+      REQUIRE(hashes[1] == std::hash<std::string>{}(keys[1]));
+   }
+
+   SECTION("too few hashes") {
+      std::array<std::uint64_t, 3> const keys = {};
+      std::array<std::size_t, 2> hashes = {};
+      REQUIRE_THROWS_AS(hash_utilities::hash(std::span<std::uint64_t const>{keys}, std::span{hashes}),
+                        std::out_of_range);
+   }
+}
+
+TEST_CASE("hashed_key keeps the hash of its key", "[hash]") {
+   key_hash const h;
+   hashed_key const owned{std::string{"tenant-7"}};
+   hashed_key const viewed{"tenant-7"};
+   static_assert(std::same_as<decltype(viewed), hashed_key<std::string_view> const>);
+   static_assert(key<decltype(owned)::key_type>);
+   static_assert(key<hashed_key<std::string_view> >);
+   static_assert(key<hashed_key<std::span<std::byte const> >, key_hash>);
+   static_assert(std::same_as<decltype(owned)::hasher, standard_hash>);
+   REQUIRE(owned.hash() == std::hash<std::string>{}("tenant-7"));
+   REQUIRE(viewed.hash() == owned.hash());
+   REQUIRE(std::hash<hashed_key<std::string_view> >{}(viewed) == viewed.hash());
+   REQUIRE(h(viewed) == h(std::string_view{"tenant-7"}));
+   REQUIRE(viewed == hashed_key{"tenant-7"});
+   REQUIRE(viewed != hashed_key{"tenant-8"});
+   REQUIRE(viewed < hashed_key{"tenant-8"});
+
+   hashed_key const mixed{std::string_view{"tenant-7"}, h};
+   REQUIRE(mixed.hash() == h(std::string{"tenant-7"}));
+   REQUIRE(h(mixed) == mixed.hash());
+   REQUIRE(std::hash<hashed_key<std::string_view, key_hash> >{}(mixed) == std::hash<std::string_view>{}("tenant-7"));
+}
+
+TEST_CASE("hashed_key compares spans by their elements", "[hash]") {
+   std::array<std::byte, 3> const a = {std::byte{1}, std::byte{2}, std::byte{3}};
+   std::vector<std::byte> const b(a.begin(), a.end());
+   hashed_key const x{std::span<std::byte const>{a}};
+   hashed_key const y{std::span<std::byte const>{b}};
+   static_assert(std::same_as<decltype(x)::hasher, key_hash>);
+   REQUIRE(x == y);
+   REQUIRE(x.hash() == xxh3::compute(a));
+   REQUIRE(x != hashed_key{std::span<std::byte const>{a}.first(2)});
+}
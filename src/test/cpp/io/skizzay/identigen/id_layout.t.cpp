@@ -0,0 +1,98 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/id_layout.h>
+#include <io/skizzay/identigen/value_provider.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+TEST_CASE("id_layout computes shifts and masks at compile time", "[id_layout]") {
+   using layout = id_layout<41, 10, 12>;
+   STATIC_REQUIRE(layout::num_fields == 3);
+   STATIC_REQUIRE(layout::num_significant_bits() == 63);
+   STATIC_REQUIRE(layout::shift(0) == 22);
+   STATIC_REQUIRE(layout::shift(1) == 12);
+   STATIC_REQUIRE(layout::shift(2) == 0);
+   STATIC_REQUIRE(layout::mask(1) == 0x3ffull << 12);
+   STATIC_REQUIRE(layout::pack({1, 2, 3}) == ((1ull << 22) | (2ull << 12) | 3ull));
+}
+
+TEST_CASE("id_layout masks fields that exceed their width", "[id_layout]") {
+   using layout = id_layout<4, 4>;
+   STATIC_REQUIRE(layout::pack({0x1f, 0x1f}) == 0xff);
+   REQUIRE(layout::pack({0x1f, 0x1f}) == 0xff);
+}
+
+TEST_CASE("id_layout decodes and unpacks fields", "[id_layout]") {
+   using layout = id_layout<41, 10, 12>;
+   constexpr auto id = layout::pack({123456789, 513, 4095});
+   STATIC_REQUIRE(layout::decode<0>(id) == 123456789);
+   STATIC_REQUIRE(layout::decode<1>(id) == 513);
+   REQUIRE(layout::decode<2>(id) == 4095);
+   REQUIRE(layout::unpack(id) == std::array<std::uint64_t, 3>{123456789, 513, 4095});
+}
+
+TEST_CASE("id_layout decodes a span of IDs", "[id_layout]") {
+   using layout = id_layout<32, 16, 16>;
+   std::vector<std::uint64_t> ids;
+   for (std::uint64_t i = 0; i < 100; ++i) {
+      ids.push_back(layout::pack({i * 3, i, 7}));
+   }
+   std::vector<std::uint64_t> fields(ids.size());
+   layout::decode<0>(ids, fields);
+   for (std::uint64_t i = 0; i < 100; ++i) {
+      REQUIRE(fields[i] == i * 3);
+   }
+   std::vector<std::uint64_t> too_small(ids.size() - 1);
+   REQUIRE_THROWS_AS(layout::decode<1>(ids, too_small), std::out_of_range);
+}
+
+TEST_CASE("id_layout supports a full 64-bit field", "[id_layout]") {
+   using layout = id_layout<64>;
+   STATIC_REQUIRE(layout::pack({~0ull}) == ~0ull);
+   REQUIRE(layout::decode<0>(~0ull) == ~0ull);
+}
+
+TEST_CASE("id_layout decodes a zero-width field above a full 64-bit layout", "[id_layout]") {
+   using layout = id_layout<0, 64>;
+   std::vector<std::uint64_t> const ids = {~0ull, 42};
+   std::vector<std::uint64_t> fields(ids.size(), 1);
+   layout::decode<0>(ids, fields);
+   REQUIRE(fields == std::vector<std::uint64_t>{0, 0});
+   layout::decode<1>(ids, fields);
+   REQUIRE(fields == ids);
+
+   dynamic_id_layout<2> const dynamic{{0, 64}};
+   std::ranges::fill(fields, 1);
+   dynamic.decode<0>(ids, fields);
+   REQUIRE(fields == std::vector<std::uint64_t>{0, 0});
+   dynamic.decode<1>(ids, fields);
+   REQUIRE(fields == ids);
+}
+
+TEST_CASE("id_layout_for builds a layout from value provider factories", "[id_layout]") {
+   using layout = id_layout_for<12, [] { return value_provider_utilities::from_constant(42); }, [] {
+      return value_provider_utilities::partitioned(1024);
+   }>;
+   STATIC_REQUIRE(std::same_as<layout, id_layout<6, 10, 12> >);
+}
+
+TEST_CASE("dynamic_id_layout matches id_layout", "[id_layout]") {
+   using expected = id_layout<41, 10, 12>;
+   dynamic_id_layout<3> const actual{{41, 10, 12}};
+   REQUIRE(actual.num_significant_bits() == expected::num_significant_bits());
+   auto const id = actual.pack({123456789, 513, 4095});
+   REQUIRE(id == expected::pack({123456789, 513, 4095}));
+   REQUIRE(actual.decode<1>(id) == 513);
+   REQUIRE(actual.unpack(id) == expected::unpack(id));
+}
+
+TEST_CASE("dynamic_id_layout rejects layouts wider than 64 bits", "[id_layout]") {
+   REQUIRE_THROWS_AS((dynamic_id_layout<2>{{60, 8}}), std::invalid_argument);
+   REQUIRE_THROWS_AS((dynamic_id_layout<1>{{65}}), std::invalid_argument);
+}
@@ -0,0 +1,76 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/io_vector.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+
+TEST_CASE("io_vector writes several buffers with one writev", "[io_vector]") {
+   std::array<std::byte, 64> header_bytes{};
+   write_buffer<std::endian::big> header{header_bytes};
+   header.put(std::uint32_t{0xcafe});
+   auto body = header.subwriter(header.position() + 4, 8);
+   body.put(std::uint64_t{0x0102030405060708});
+
+   std::vector<std::byte> payload(300000, std::byte{9});
+   chained_write_buffer<std::endian::big> chained;
+   chained.put(std::uint16_t{3}).put_reference(payload);
+
+   io_vector target;
+   target.append(header).append(body).append(chained);
+   REQUIRE(target.size_bytes() == 4 + 8 + 2 + 8 + payload.size());
+
+   temporary_file const file;
+   REQUIRE(0 <= file.fd);
+   REQUIRE(io_vector_utilities::write(file.fd, target) == target.size_bytes());
+
+   std::vector<std::byte> expected(target.size_bytes());
+   write_buffer<std::endian::big> flat{expected};
+   flat.put(std::uint32_t{0xcafe}).put(std::uint64_t{0x0102030405060708}).put(std::uint16_t{3}).put(payload);
+   REQUIRE(file.contents() == expected);
+}
+
+TEST_CASE("io_vector writes at an offset with pwritev", "[io_vector]") {
+   std::array<std::byte, 4> first{std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4}};
+   std::array<std::byte, 2> second{std::byte{5}, std::byte{6}};
+   io_vector target;
+   target.append(first).append(second).append(std::span<std::byte const>{});
+   REQUIRE(target.iovecs().size() == 2);
+
+   temporary_file const file;
+   REQUIRE(io_vector_utilities::write(file.fd, 3, target) == 6);
+   REQUIRE(::lseek(file.fd, 0, SEEK_CUR) == 0);
+   auto const contents = file.contents();
+   REQUIRE(contents.size() == 9);
+   REQUIRE(contents[3] == std::byte{1});
+   REQUIRE(contents[8] == std::byte{6});
+}
+
+TEST_CASE("io_vector reports write failures", "[io_vector]") {
+   io_vector target;
+   std::array<std::byte, 1> byte{};
+   target.append(byte);
+   REQUIRE_THROWS_AS(io_vector_utilities::write(-1, target), std::system_error);
+}
+
+TEST_CASE("io_vector writes more buffers than one writev takes", "[io_vector]") {
+   std::vector<std::array<std::byte, 3> > pieces(3000);
+   io_vector target;
+   for (std::size_t i = 0; i < pieces.size(); ++i) {
+      pieces[i].fill(static_cast<std::byte>(i));
+      target.append(pieces[i]);
+   }
+   temporary_file const file;
+   REQUIRE(io_vector_utilities::write(file.fd, target) == 9000);
+   auto const contents = file.contents();
+   REQUIRE(contents.size() == 9000);
+   REQUIRE(contents[8999] == static_cast<std::byte>(2999));
+}
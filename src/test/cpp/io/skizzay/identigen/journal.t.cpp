@@ -0,0 +1,195 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/journal.h>
+#include <io/skizzay/identigen/generator.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+using namespace std::chrono;
+
+TEST_CASE("high_water_mark_journal starts empty", "[journal]") {
+   temporary_path const file;
+   high_water_mark_journal const target{file.path};
+   REQUIRE_FALSE(target.recovered().has_value());
+}
+
+TEST_CASE("high_water_mark_journal recovers the latest mark", "[journal]") {
+   temporary_path const file;
+   {
+      high_water_mark_journal target{file.path};
+      target.record(nanoseconds{10});
+      target.record(nanoseconds{20});
+      target.record(nanoseconds{30});
+      target.sync();
+   }
+   high_water_mark_journal target{file.path};
+   REQUIRE(target.recovered() == nanoseconds{30});
+   target.record(nanoseconds{40});
+   target.sync();
+   REQUIRE(high_water_mark_journal{file.path}.recovered() == nanoseconds{40});
+}
+
+TEST_CASE("high_water_mark_journal falls back to the previous mark when the latest is torn", "[journal]") {
+   temporary_path const file;
+   {
+      high_water_mark_journal target{file.path};
+      target.record(nanoseconds{10});
+      target.record(nanoseconds{20});
+      target.sync();
+   }
+   auto const fd = ::open(file.path.c_str(), O_WRONLY);
+   REQUIRE(0 <= fd);
+   // The second record is in the first slot; tear its mark
+   std::int64_t const torn = 99;
+   REQUIRE(sizeof(torn) == ::pwrite(fd, &torn, sizeof(torn), sizeof(std::uint64_t)));
+   ::close(fd);
+   REQUIRE(high_water_mark_journal{file.path}.recovered() == nanoseconds{10});
+}
+
+TEST_CASE("high_water_mark_journal keeps a restarted generator ahead of the previous run", "[journal]") {
+   temporary_path const file;
+   auto const epoch = sys_time<milliseconds>{};
+   std::atomic<std::int64_t> now{1000};
+   std::uint64_t last;
+   {
+      generator previous{manual_clock{&now}, 8, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+      high_water_mark_journal journal{file.path};
+      journal_checkpointer checkpointer{journal, previous, hours{1}, milliseconds{5}};
+      now = 1003;
+      last = previous.next();
+      checkpointer.checkpoint();
+   }
+
+   // The clock steps back across the restart
+   now = 500;
+   generator restarted{clock_regression_policy::borrow(nanoseconds::max()), manual_clock{&now}, 8,
+                       value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   high_water_mark_journal const journal{file.path};
+   REQUIRE(journal.recovered() == milliseconds{1008});
+   journal.restore(restarted);
+   auto const first = restarted.next();
+   REQUIRE(last < first);
+   REQUIRE(restarted.high_water_mark() == sys_time<milliseconds>{milliseconds{1009}});
+}
+
+TEST_CASE("high_water_mark_journal restarts a generator without waiting for its clock to reach the mark",
+          "[journal]") {
+   temporary_path const file;
+   auto const epoch = sys_time<milliseconds>{};
+   std::atomic<std::int64_t> now{1000};
+   {
+      high_water_mark_journal journal{file.path};
+      journal.record(milliseconds{1008});
+      journal.sync();
+   }
+
+   generator restarted{manual_clock{&now}, 8, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   high_water_mark_journal const journal{file.path};
+   journal.restore(restarted);
+   std::vector<std::uint64_t> ids(256);
+   REQUIRE(ids.size() == restarted.try_generate_n(ids, 0));
+   REQUIRE(restarted.high_water_mark() == sys_time<milliseconds>{milliseconds{1009}});
+
+   // Once the tick after the mark is used up, the generator only runs ahead as far as the mark was
+   REQUIRE_FALSE(restarted.try_next(0).has_value());
+   now = 1001;
+   REQUIRE(restarted.try_next(0).has_value());
+   REQUIRE(restarted.high_water_mark() == sys_time<milliseconds>{milliseconds{1010}});
+
+   // When the clock passes the mark, the default policy applies again
+   now = 1011;
+   std::vector<std::uint64_t> more(512);
+   REQUIRE(256 == restarted.try_generate_n(more, 0));
+}
+
+TEST_CASE("journal_checkpointer keeps a generator within the mark on disk", "[journal]") {
+   temporary_path const file;
+   std::atomic<std::int64_t> now{1000};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{manual_clock{&now}, 8, value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   high_water_mark_journal journal{file.path};
+   {
+      journal_checkpointer checkpointer{journal, target, hours{1}, milliseconds{5}};
+      now = 1004;
+      REQUIRE(target.try_next(0).has_value());
+
+      // Past the mark, generation waits for the next checkpoint
+      now = 1010;
+      REQUIRE_FALSE(target.try_next(0).has_value());
+      checkpointer.checkpoint();
+      REQUIRE(journal.recovered() == std::nullopt);
+      REQUIRE(high_water_mark_journal{file.path}.recovered() == milliseconds{1015});
+      REQUIRE(target.try_next(0).has_value());
+   }
+
+   // Without a checkpointer the generator is no longer held back
+   now = 2000;
+   REQUIRE(target.try_next(0).has_value());
+   REQUIRE_THROWS_AS((journal_checkpointer{journal, target, hours{1}, nanoseconds{0}}), std::invalid_argument);
+}
+
+namespace {
+   // Timestamp provider that throws on every thread but the test's while the test has it failing
+   struct failing_clock final {
+      std::atomic<std::int64_t> *now;
+      std::atomic<bool> *failing;
+      std::thread::id test = std::this_thread::get_id();
+
+      sys_time<milliseconds> operator()() const {
+         if (failing->load() && std::this_thread::get_id() != test) {
+            throw std::runtime_error{"clock failed"};
+         }
+         return sys_time<milliseconds>{milliseconds{now->load()}};
+      }
+   };
+
+   template<typename Checkpointer>
+   bool eventually_fails(Checkpointer const &checkpointer, bool const expected) {
+      for (int attempt = 0; attempt < 5000; ++attempt) {
+         try {
+            checkpointer.rethrow_failure();
+            if (!expected) {
+               return true;
+            }
+         }
+         catch (std::runtime_error const &) {
+            if (expected) {
+               return true;
+            }
+         }
+         std::this_thread::sleep_for(milliseconds{1});
+      }
+      return false;
+   }
+}
+
+TEST_CASE("journal_checkpointer reports a failed background checkpoint and holds at the last mark", "[journal]") {
+   temporary_path const file;
+   std::atomic<std::int64_t> now{1000};
+   std::atomic<bool> failing{false};
+   auto const epoch = sys_time<milliseconds>{};
+   generator target{failing_clock{&now, &failing}, 8,
+                    value_provider_utilities::from_timestamp(epoch, milliseconds{1 << 20})};
+   high_water_mark_journal journal{file.path};
+   journal_checkpointer checkpointer{journal, target, milliseconds{1}, milliseconds{5}};
+
+   failing = true;
+   REQUIRE(eventually_fails(checkpointer, true));
+   now = 1100;
+   REQUIRE_FALSE(target.try_next(0).has_value());
+
+   failing = false;
+   REQUIRE(eventually_fails(checkpointer, false));
+   REQUIRE(target.try_next(0).has_value());
+}
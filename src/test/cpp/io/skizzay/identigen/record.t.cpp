@@ -0,0 +1,102 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/buffer.h>
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   enum class kind : std::uint8_t {
+      node = 1,
+      lease = 2
+   };
+
+   struct span_header {
+      std::uint64_t id;
+      kind type;
+      std::array<std::uint16_t, 3> shards;
+
+      bool operator==(span_header const &) const = default;
+   };
+
+   struct lease_record {
+      span_header header;
+      std::pair<std::int32_t, double> window;
+      float weight;
+      bool active;
+
+      bool operator==(lease_record const &) const = default;
+   };
+
+   struct named {
+      std::uint64_t id;
+      std::string name;
+   };
+
+   struct empty {
+   };
+}
+
+TEST_CASE("record_utilities sizes records at compile time", "[record]") {
+   static_assert(record_utilities::size<std::uint32_t>() == 4);
+   static_assert(record_utilities::size<kind>() == 1);
+   static_assert(record_utilities::size<std::tuple<std::uint8_t, double, std::int16_t> >() == 11);
+   static_assert(record_utilities::size<std::array<std::uint32_t, 5> >() == 20);
+   static_assert(record_utilities::size<span_header>() == 8 + 1 + 6);
+   static_assert(record_utilities::size<lease_record>() == 15 + 4 + 8 + 4 + 1);
+   static_assert(fixed_size_record<lease_record>);
+   static_assert(!fixed_size_record<named>);
+   static_assert(!fixed_size_record<empty>);
+   static_assert(!fixed_size_record<std::tuple<std::uint8_t, std::string> >);
+   SUCCEED();
+}
+
+TEMPLATE_TEST_CASE_SIG("read_buffer reads records written by a write_buffer", "[record,read_buffer,write_buffer]",
+                       ((std::endian E), E), std::endian::little, std::endian::big) {
+   lease_record const expected{{0x0123456789abcdef, kind::lease, {1, 2, 3}}, {-7, 0.125}, 1.5f, true};
+   std::tuple<std::int8_t, std::uint64_t> const trailer{-1, 42};
+   std::array<std::byte, record_utilities::size<lease_record>() + record_utilities::size<decltype(trailer)>() > buffer{};
+   write_buffer<E> writer{buffer};
+   writer.put_record(expected).put_record(trailer);
+   REQUIRE(writer.remaining() == 0);
+
+   read_buffer<E> reader{writer.to_input_buffer()};
+   REQUIRE(reader.template get_record<lease_record>() == expected);
+   REQUIRE(reader.template get_record<std::tuple<std::int8_t, std::uint64_t> >() == trailer);
+   REQUIRE(reader.remaining() == 0);
+}
+
+TEST_CASE("write_buffer writes records field by field without padding", "[record,write_buffer]") {
+   span_header const header{0x0102030405060708, kind::node, {0x0a0b, 0x0c0d, 0x0e0f}};
+   std::array<std::byte, record_utilities::size<span_header>() > buffer{};
+   write_buffer<std::endian::big> writer{buffer};
+   writer.put_record(header);
+   std::array<std::byte, 15> const expected{
+      std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4}, std::byte{5}, std::byte{6}, std::byte{7}, std::byte{8},
+      std::byte{1}, std::byte{0x0a}, std::byte{0x0b}, std::byte{0x0c}, std::byte{0x0d}, std::byte{0x0e},
+      std::byte{0x0f}
+   };
+   REQUIRE(buffer == expected);
+}
+
+TEST_CASE("records that do not fit leave the buffer untouched", "[record,read_buffer,write_buffer]") {
+   span_header const header{1, kind::node, {2, 3, 4}};
+   std::array<std::byte, record_utilities::size<span_header>() - 1> buffer{};
+   write_buffer<std::endian::little> writer{buffer};
+   REQUIRE(writer.try_put_record(header).error() == buffer_error::not_enough_space);
+   REQUIRE_THROWS_AS(writer.put_record(header), buffer_overflow);
+   REQUIRE(writer.position() == 0);
+
+   read_buffer<std::endian::little> reader{buffer};
+   REQUIRE(reader.try_get_record<span_header>().error() == buffer_error::not_enough_space);
+   REQUIRE_THROWS_AS(reader.get_record<span_header>(), buffer_overflow);
+   REQUIRE(reader.position() == 0);
+}
@@ -0,0 +1,136 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/segment_allocator.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   struct counting_coordinator final {
+      local_segment_coordinator *coordinator;
+      std::atomic<std::size_t> *leases;
+
+      std::uint64_t lease(std::uint64_t const n) noexcept {
+         leases->fetch_add(1);
+         leases->notify_all();
+         return coordinator->lease(n);
+      }
+   };
+
+   struct failing_coordinator final {
+      std::uint64_t lease(std::uint64_t) {
+         throw std::runtime_error{"coordinator unavailable"};
+      }
+   };
+
+   // Coordinator that is unavailable while a test has it failing
+   struct flaky_coordinator final {
+      local_segment_coordinator *coordinator;
+      std::atomic<bool> *failing;
+
+      std::uint64_t lease(std::uint64_t const n) {
+         if (failing->load()) {
+            throw std::runtime_error{"coordinator unavailable"};
+         }
+         return coordinator->lease(n);
+      }
+   };
+}
+
+TEST_CASE("segment_allocator issues consecutive IDs from leased segments", "[segment_allocator]") {
+   local_segment_coordinator coordinator{1000};
+   std::atomic<std::size_t> leases{0};
+   segment_allocator target{counting_coordinator{&coordinator, &leases}, 10};
+   REQUIRE(target.segment_size() == 10);
+   for (std::uint64_t i = 0; i < 25; ++i) {
+      REQUIRE(target.next() == 1000 + i);
+   }
+}
+
+TEST_CASE("segment_allocator prefetches the next segment in the background", "[segment_allocator]") {
+   local_segment_coordinator coordinator;
+   std::atomic<std::size_t> leases{0};
+   segment_allocator target{counting_coordinator{&coordinator, &leases}, 100, 0.25};
+   for (int i = 0; i < 30; ++i) {
+      static_cast<void>(target.next());
+   }
+   for (auto n = leases.load(); n < 2; n = leases.load()) {
+      leases.wait(n);
+   }
+   REQUIRE(leases.load() == 2);
+}
+
+TEST_CASE("segment_allocator does not overlap segments leased by other allocators", "[segment_allocator]") {
+   local_segment_coordinator coordinator;
+   std::atomic<std::size_t> leases{0};
+   segment_allocator first{counting_coordinator{&coordinator, &leases}, 16};
+   segment_allocator second{counting_coordinator{&coordinator, &leases}, 16};
+   std::vector<std::uint64_t> ids;
+   for (int i = 0; i < 200; ++i) {
+      ids.push_back(first.next());
+      ids.push_back(second.next());
+   }
+   std::ranges::sort(ids);
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
+
+TEST_CASE("segment_allocator issues unique IDs across threads", "[segment_allocator]") {
+   local_segment_coordinator coordinator;
+   std::atomic<std::size_t> leases{0};
+   segment_allocator target{counting_coordinator{&coordinator, &leases}, 64};
+   std::vector<std::vector<std::uint64_t> > ids(4);
+   {
+      std::vector<std::jthread> threads;
+      for (auto &thread_ids: ids) {
+         threads.emplace_back([&target, &thread_ids] {
+            thread_ids.resize(5'000);
+            std::ranges::generate(thread_ids, [&target] { return target.next(); });
+         });
+      }
+   }
+   std::vector<std::uint64_t> all;
+   for (auto const &thread_ids: ids) {
+      all.insert(all.end(), thread_ids.begin(), thread_ids.end());
+   }
+   std::ranges::sort(all);
+   REQUIRE(std::ranges::adjacent_find(all) == all.end());
+}
+
+TEST_CASE("segment_allocator rethrows coordinator failures", "[segment_allocator]") {
+   segment_allocator target{failing_coordinator{}, 8};
+   REQUIRE_THROWS_AS(target.next(), std::runtime_error);
+}
+
+TEST_CASE("segment_allocator recovers once the coordinator does", "[segment_allocator]") {
+   local_segment_coordinator coordinator;
+   std::atomic<bool> failing{true};
+   segment_allocator target{flaky_coordinator{&coordinator, &failing}, 8};
+   REQUIRE_THROWS_AS(target.next(), std::runtime_error);
+   REQUIRE_THROWS_AS(target.next(), std::runtime_error);
+
+   failing = false;
+   std::optional<std::uint64_t> id;
+   for (int attempt = 0; attempt < 5000 && !id; ++attempt) {
+      try {
+         id = target.next();
+      }
+      catch (std::runtime_error const &) {
+         std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+   }
+   REQUIRE(id.has_value());
+   REQUIRE(target.next() == *id + 1);
+}
+
+TEST_CASE("segment_allocator validates its configuration", "[segment_allocator]") {
+   REQUIRE_THROWS_AS((segment_allocator{failing_coordinator{}, 0}), std::invalid_argument);
+   REQUIRE_THROWS_AS((segment_allocator{failing_coordinator{}, 8, 1.5}), std::invalid_argument);
+}
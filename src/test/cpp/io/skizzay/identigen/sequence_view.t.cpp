@@ -0,0 +1,93 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/sequence_view.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+static_assert(std::ranges::forward_range<sequence_view<std::uint32_t, std::endian::little> >);
+static_assert(std::ranges::view<sequence_view<std::uint32_t, std::endian::little> >);
+static_assert(std::ranges::sized_range<sequence_view<std::span<std::byte const>, std::endian::big> >);
+
+TEMPLATE_TEST_CASE_SIG("sequence_view decodes scalars lazily", "[sequence_view]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   std::vector<std::int32_t> const expected = {5, -4, 3, -2, 1};
+   std::vector<std::byte> buffer(256);
+   write_buffer<E> writer{buffer};
+   writer.put(expected).put(std::uint8_t{9});
+
+   read_buffer<E> reader{writer.to_input_buffer()};
+   sequence_view<std::int32_t, E> const values{reader};
+   REQUIRE(values.size() == expected.size());
+   REQUIRE(std::ranges::equal(values, expected));
+   auto negative = values | std::views::filter([](auto const x) { return x < 0; });
+   REQUIRE(std::ranges::equal(negative, std::vector{-4, -2}));
+   REQUIRE(static_cast<std::uint8_t>(reader.get()) == 9);
+}
+
+TEMPLATE_TEST_CASE_SIG("sequence_view reads nested sequences and byte spans", "[sequence_view]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   std::vector<std::vector<std::uint64_t> > const matrix = {{1, 2}, {}, {3, 4, 5}};
+   std::vector<std::string> const names = {"alpha", "", "gamma"};
+   std::vector<std::byte> buffer(512);
+   write_buffer<E> writer{buffer};
+   writer.put(matrix).put(names);
+
+   read_buffer<E> reader{writer.to_input_buffer()};
+   sequence_view<sequence_view<std::uint64_t, E>, E> const rows{reader};
+   REQUIRE(rows.size() == 3);
+   auto expected_row = matrix.begin();
+   for (auto const row: rows) {
+      REQUIRE(std::ranges::equal(row, *expected_row++));
+   }
+
+   sequence_view<std::span<std::byte const>, E> const texts{reader};
+   std::vector<std::string> actual;
+   for (auto const text: texts) {
+      actual.emplace_back(reinterpret_cast<char const *>(text.data()), text.size());
+   }
+   REQUIRE(actual == names);
+   REQUIRE(reader.remaining() == 0);
+}
+
+TEST_CASE("sequence_view skips whole columns without decoding them", "[sequence_view]") {
+   std::vector<std::vector<std::uint32_t> > wide(1000, std::vector<std::uint32_t>(16, 7));
+   std::vector<std::string> labels(500, "label");
+   std::vector<std::uint16_t> const wanted = {1, 2, 3};
+   std::vector<std::byte> buffer(128 * 1024);
+   write_buffer<std::endian::big> writer{buffer};
+   writer.put(wide).put(labels).put(wanted);
+
+   read_buffer<std::endian::big> reader{writer.to_input_buffer()};
+   sequence_view<sequence_view<std::uint32_t, std::endian::big>, std::endian::big>::skip(reader);
+   sequence_view<std::span<std::byte const>, std::endian::big>::skip(reader);
+   REQUIRE(std::ranges::equal(sequence_view<std::uint16_t, std::endian::big>{reader}, wanted));
+   REQUIRE(reader.remaining() == 0);
+}
+
+TEST_CASE("sequence_view rejects truncated sequences without moving the reader", "[sequence_view]") {
+   std::vector<std::vector<std::uint32_t> > const matrix = {{1, 2}, {3, 4}};
+   std::vector<std::byte> buffer(256);
+   write_buffer<std::endian::little> writer{buffer};
+   writer.put(matrix);
+
+   read_buffer<std::endian::little> truncated{writer.to_input_buffer(0, writer.position() - 1)};
+   using rows = sequence_view<sequence_view<std::uint32_t, std::endian::little>, std::endian::little>;
+   REQUIRE_THROWS_AS((rows{truncated}), buffer_overflow);
+   REQUIRE_THROWS_AS(rows::skip(truncated), buffer_overflow);
+   REQUIRE(truncated.position() == 0);
+
+   std::array<std::byte, sizeof(std::size_t)> huge{};
+   std::ranges::fill(huge, std::byte{0xff});
+   read_buffer<std::endian::little> corrupt{huge};
+   REQUIRE_THROWS_AS((sequence_view<std::uint64_t, std::endian::little>{corrupt}), buffer_overflow);
+}
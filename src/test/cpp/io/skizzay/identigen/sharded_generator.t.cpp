@@ -0,0 +1,110 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/sharded_generator.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+
+using namespace std::chrono;
+
+TEST_CASE("value_provider_utilities from_shard", "[value_provider]") {
+   constexpr auto provider = value_provider_utilities::from_shard(2, 16);
+   REQUIRE(provider.value(system_clock::now(), 1) == 2);
+   REQUIRE(provider.num_significant_bits() == 4);
+}
+
+TEST_CASE("sharded_generator packs the shard index between the providers and the sequence", "[sharded_generator]") {
+   std::atomic<std::int64_t> now{0};
+   sharded_generator target{8, manual_clock{&now}, 4, value_provider_utilities::from_constant(5)};
+   REQUIRE(target.num_shards() == 8);
+   REQUIRE(target.num_sequence_bits() == 4);
+   REQUIRE(target.num_significant_bits() == 3 + 3 + 4);
+   auto const id = target.next();
+   auto const shard = thread_shard_selector{}(8);
+   REQUIRE(id == target.layout().pack({5, shard, 0}));
+   REQUIRE(target.next() == target.layout().pack({5, shard, 1}));
+}
+
+TEST_CASE("sharded_generator gives each thread its own shard", "[sharded_generator]") {
+   std::atomic<std::int64_t> now{0};
+   constexpr std::size_t num_threads = 4;
+   constexpr std::size_t num_ids = 2'000;
+   sharded_generator target{num_threads, manual_clock{&now}, 16,
+                            value_provider_utilities::from_timestamp(sys_time<milliseconds>{}, milliseconds{1 << 20})};
+   std::vector<std::vector<std::uint64_t> > ids(num_threads);
+   {
+      std::vector<std::jthread> threads;
+      for (auto &thread_ids: ids) {
+         threads.emplace_back([&target, &thread_ids] {
+            thread_ids.resize(num_ids);
+            target.generate_n(std::span{thread_ids}.first(num_ids / 2), 0);
+            std::ranges::generate(std::span{thread_ids}.subspan(num_ids / 2), [&target] { return target.next(); });
+         });
+      }
+   }
+   std::set<std::uint64_t> shards;
+   std::vector<std::uint64_t> all;
+   for (auto const &thread_ids: ids) {
+      shards.insert(target.layout().decode<1>(thread_ids.front()));
+      REQUIRE(std::ranges::all_of(thread_ids, [&](auto const id) {
+         return target.layout().decode<1>(id) == target.layout().decode<1>(thread_ids.front());
+      }));
+      all.insert(all.end(), thread_ids.begin(), thread_ids.end());
+   }
+   REQUIRE(shards.size() == num_threads);
+   std::ranges::sort(all);
+   REQUIRE(std::ranges::adjacent_find(all) == all.end());
+}
+
+TEST_CASE("sharded_generator stays unique when threads share a shard", "[sharded_generator]") {
+   std::atomic<std::int64_t> now{0};
+   sharded_generator target{1, manual_clock{&now}, 20};
+   std::vector<std::vector<std::uint64_t> > ids(4);
+   {
+      std::vector<std::jthread> threads;
+      for (auto &thread_ids: ids) {
+         threads.emplace_back([&target, &thread_ids] {
+            thread_ids.resize(1'000);
+            std::ranges::generate(thread_ids, [&target] { return target.next(); });
+         });
+      }
+   }
+   std::vector<std::uint64_t> all;
+   for (auto const &thread_ids: ids) {
+      all.insert(all.end(), thread_ids.begin(), thread_ids.end());
+   }
+   std::ranges::sort(all);
+   REQUIRE(std::ranges::adjacent_find(all) == all.end());
+}
+
+TEST_CASE("sharded_generator requires at least one shard", "[sharded_generator]") {
+   std::atomic<std::int64_t> now{0};
+   REQUIRE_THROWS_AS((sharded_generator{0, manual_clock{&now}, 4}), std::invalid_argument);
+}
+
+TEST_CASE("per_cpu_generator packs the current CPU as the shard index", "[sharded_generator]") {
+   std::atomic<std::int64_t> now{0};
+   per_cpu_generator target{manual_clock{&now}, 12};
+   REQUIRE(target.num_shards() == value_provider_utilities::num_cpus());
+   std::vector<std::uint64_t> ids(4 * target.num_shards());
+   {
+      std::vector<std::jthread> threads;
+      for (auto &id: ids) {
+         threads.emplace_back([&target, &id] { id = target.next(); });
+      }
+   }
+   for (auto const id: ids) {
+      REQUIRE(target.layout().decode<0>(id) < target.num_shards());
+   }
+   std::ranges::sort(ids);
+   REQUIRE(std::ranges::adjacent_find(ids) == ids.end());
+}
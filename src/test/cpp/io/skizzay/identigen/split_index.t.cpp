@@ -0,0 +1,82 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/split_index.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+namespace {
+   template<typename K>
+   std::vector<K> random_split_points(std::size_t const n, std::mt19937_64 &random) {
+      std::vector<K> result;
+      while (result.size() < n) {
+         result.push_back(static_cast<K>(random()));
+         std::ranges::sort(result);
+         result.erase(std::ranges::unique(result).begin(), result.end());
+      }
+      return result;
+   }
+
+   template<typename K>
+   std::size_t expected_rank(std::vector<K> const &split_points, K const &k) {
+      return static_cast<std::size_t>(std::ranges::upper_bound(split_points, k) - split_points.begin());
+   }
+}
+
+TEMPLATE_TEST_CASE("split_index ranks integer keys", "[split_index]", std::int64_t, std::uint64_t, std::int32_t,
+                   std::uint32_t, std::int16_t) {
+   std::mt19937_64 random{7};
+   // Sizes either side of the small fan-out and of full Eytzinger levels
+   auto const n = GENERATE(as<std::size_t>{}, 0, 1, 2, 5, 15, 16, 17, 31, 32, 100, 1000);
+   auto const split_points = random_split_points<TestType>(n, random);
+   split_index<TestType> const index{split_points};
+   REQUIRE(index.size() == n);
+
+   std::vector<TestType> keys = {std::numeric_limits<TestType>::min(), std::numeric_limits<TestType>::max(), 0};
+   for (auto const point: split_points) {
+      keys.push_back(point);
+      keys.push_back(static_cast<TestType>(point - 1));
+      keys.push_back(static_cast<TestType>(point + 1));
+   }
+   for (int i = 0; i < 1000; ++i) {
+      keys.push_back(static_cast<TestType>(random()));
+   }
+   for (auto const k: keys) {
+      REQUIRE(index.rank(k) == expected_rank(split_points, k));
+   }
+}
+
+TEST_CASE("split_index ranks ordered keys of any type", "[split_index]") {
+   std::vector<std::string> const split_points = {"b", "d", "dd", "m", "x"};
+   split_index const index{split_points};
+   REQUIRE(index.rank("") == 0);
+   REQUIRE(index.rank("a") == 0);
+   REQUIRE(index.rank("b") == 1);
+   REQUIRE(index.rank("cat") == 1);
+   REQUIRE(index.rank("d") == 2);
+   REQUIRE(index.rank("dd") == 3);
+   REQUIRE(index.rank("lemon") == 3);
+   REQUIRE(index.rank("m") == 4);
+   REQUIRE(index.rank("zebra") == 5);
+}
+
+TEST_CASE("split_index without split points ranks every key 0", "[split_index]") {
+   split_index<std::string> const index{std::vector<std::string>{}};
+   REQUIRE(index.size() == 0);
+   REQUIRE(index.rank("") == 0);
+   REQUIRE(index.rank("x") == 0);
+}
+
+TEST_CASE("split_index requires strictly increasing split points", "[split_index]") {
+   REQUIRE_THROWS_AS((split_index{std::vector{1, 3, 2}}), std::invalid_argument);
+   REQUIRE_THROWS_AS((split_index{std::vector{1, 2, 2}}), std::invalid_argument);
+}
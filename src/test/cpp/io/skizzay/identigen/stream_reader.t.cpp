@@ -0,0 +1,129 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#include <io/skizzay/identigen/stream_reader.h>
+#include <catch2/catch_all.hpp>
+#include "test_support.h"
+
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace io::skizzay::identigen;
+using namespace io::skizzay::identigen::testing;
+
+namespace {
+   // Page faults this thread has taken that were served without reading the disk
+   long minor_faults() {
+      ::rusage usage{};
+      ::getrusage(RUSAGE_THREAD, &usage);
+      return usage.ru_minflt;
+   }
+
+   // Records of a few odd sizes, so that values land on every offset of a small window
+   template<std::endian E>
+   std::vector<std::byte> records(std::size_t const n) {
+      std::vector<std::byte> result(n * 64);
+      write_buffer<E> writer{result};
+      std::string const name = "record";
+      for (std::size_t i = 0; i < n; ++i) {
+         writer.put(static_cast<std::uint32_t>(i)).put(static_cast<double>(i) / 4).put(name);
+         writer.put_varint(-static_cast<std::int64_t>(i * i)).put(static_cast<std::uint8_t>(i));
+      }
+      result.resize(writer.position());
+      return result;
+   }
+}
+
+TEMPLATE_TEST_CASE_SIG("stream_reader decodes records straddling refills", "[stream_reader]", ((std::endian E), E),
+                       std::endian::little, std::endian::big) {
+   auto const bytes = records<E>(200);
+   temporary_file const file{bytes};
+   for (std::size_t const window: {16u, 23u, 64u, 4096u}) {
+      auto const fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+      stream_reader<E> reader{fd, window};
+      for (std::size_t i = 0; i < 200; ++i) {
+         REQUIRE(static_cast<std::uint32_t>(reader.get()) == i);
+         REQUIRE(static_cast<double>(reader.get()) == static_cast<double>(i) / 4);
+         auto const name = static_cast<std::span<std::byte const> >(reader.get());
+         REQUIRE(std::string_view{reinterpret_cast<char const *>(name.data()), name.size()} == "record");
+         REQUIRE(reader.template get_varint<std::int64_t>() == -static_cast<std::int64_t>(i * i));
+         REQUIRE(static_cast<std::uint8_t>(reader.get()) == static_cast<std::uint8_t>(i));
+      }
+      REQUIRE(reader.at_end());
+      REQUIRE(reader.position() == bytes.size());
+      REQUIRE_THROWS_AS(static_cast<std::uint32_t>(reader.get()), buffer_overflow);
+      ::close(fd);
+   }
+}
+
+TEST_CASE("stream_reader reads ranges larger than its window", "[stream_reader]") {
+   std::vector<std::uint64_t> expected(1000);
+   for (std::size_t i = 0; i < expected.size(); ++i) {
+      expected[i] = i * 0x0101010101010101;
+   }
+   std::vector<std::byte> bytes(sizeof(std::size_t) + expected.size() * sizeof(std::uint64_t) + 1);
+   write_buffer<std::endian::big> writer{bytes};
+   writer.put(expected).put(std::uint8_t{7});
+   temporary_file const file{bytes};
+
+   auto const fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+   stream_reader<std::endian::big> reader{fd, 100};
+   std::vector<std::uint64_t> actual(expected.size());
+   REQUIRE(reader.get(std::span{actual}) == expected.size());
+   REQUIRE(actual == expected);
+   REQUIRE(static_cast<std::uint8_t>(reader.get()) == 7);
+   REQUIRE(reader.at_end());
+   ::close(fd);
+}
+
+TEST_CASE("stream_reader rejects spans larger than its window", "[stream_reader]") {
+   std::vector<std::byte> bytes(100);
+   write_buffer<std::endian::little> writer{bytes};
+   writer.put(std::vector<std::byte>(50));
+   temporary_file const file{bytes};
+   auto const fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+   stream_reader<std::endian::little> reader{fd, 32};
+   REQUIRE_THROWS_AS(static_cast<std::span<std::byte const> >(reader.get()), buffer_overflow);
+   ::close(fd);
+}
+
+TEST_CASE("mapped_file exposes a file to read_buffer", "[stream_reader]") {
+   auto const bytes = records<std::endian::little>(50);
+   temporary_file const file{bytes};
+   mapped_file const mapped{file.path};
+   REQUIRE(mapped.bytes().size() == bytes.size());
+   mapped.will_need(0, bytes.size());
+   read_buffer<std::endian::little> reader{mapped.bytes()};
+   for (std::uint32_t i = 0; i < 50; ++i) {
+      REQUIRE(static_cast<std::uint32_t>(reader.get()) == i);
+      static_cast<void>(static_cast<double>(reader.get()));
+      static_cast<void>(static_cast<std::span<std::byte const> >(reader.get()));
+      static_cast<void>(reader.get_varint<std::int64_t>());
+      static_cast<void>(static_cast<std::uint8_t>(reader.get()));
+   }
+   mapped.discard(reader.position());
+   REQUIRE(reader.remaining() == 0);
+   REQUIRE(std::ranges::equal(mapped.bytes(), bytes));
+}
+
+TEST_CASE("mapped_file discards up to the end of the file", "[stream_reader]") {
+   // Ends part way into a page, which discarding the whole file must drop too
+   auto const size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) + 100;
+   std::vector<std::byte> bytes(size, std::byte{7});
+   temporary_file const file{bytes};
+   mapped_file const mapped{file.path};
+   auto const last = [&mapped] { return static_cast<std::byte const volatile &>(mapped.bytes().back()); };
+   REQUIRE(last() == std::byte{7});
+
+   auto const faults = minor_faults();
+   REQUIRE(last() == std::byte{7});
+   REQUIRE(minor_faults() == faults);
+
+   mapped.discard(mapped.bytes().size());
+   REQUIRE(last() == std::byte{7});
+   REQUIRE(faults < minor_faults());
+}
@@ -0,0 +1,76 @@
+//
+// Created by andrew on 10/17/26.
+//
+
+#pragma once
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace io::skizzay::identigen::testing {
+   // Timestamp provider reading the milliseconds since the epoch a test sets by hand
+   struct manual_clock final {
+      std::atomic<std::int64_t> *now;
+
+      std::chrono::sys_time<std::chrono::milliseconds> operator()() const noexcept {
+         return std::chrono::sys_time<std::chrono::milliseconds>{std::chrono::milliseconds{now->load()}};
+      }
+   };
+
+   // Path in the temporary directory that no other test of this process uses, removed before and after the test
+   struct temporary_path final {
+      std::filesystem::path path = unique_path();
+
+      temporary_path() {
+         std::filesystem::remove(path);
+      }
+
+      ~temporary_path() {
+         std::filesystem::remove(path);
+      }
+
+      temporary_path(temporary_path const &) = delete;
+
+      temporary_path &operator=(temporary_path const &) = delete;
+
+      static std::filesystem::path unique_path() {
+         static std::atomic<int> next{0};
+         return std::filesystem::temp_directory_path() / (
+                   "identigen-" + std::to_string(::getpid()) + "-" + std::to_string(next++));
+      }
+   };
+
+   // Empty file at a temporary path, open for reading and writing
+   struct temporary_file final {
+      temporary_path const location;
+      std::filesystem::path const &path = location.path;
+      int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+      temporary_file() = default;
+
+      explicit temporary_file(std::span<std::byte const> const contents) {
+         REQUIRE(static_cast<::ssize_t>(contents.size()) == ::write(fd, contents.data(), contents.size()));
+      }
+
+      ~temporary_file() {
+         ::close(fd);
+      }
+
+      [[nodiscard]]
+      std::vector<std::byte> contents() const {
+         std::vector<std::byte> result(std::filesystem::file_size(path));
+         REQUIRE(static_cast<::ssize_t>(result.size()) == ::pread(fd, result.data(), result.size(), 0));
+         return result;
+      }
+   };
+}
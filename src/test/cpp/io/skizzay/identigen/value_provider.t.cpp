@@ -5,6 +5,15 @@
 #include <io/skizzay/identigen/value_provider.h>
 #include <catch2/catch_all.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
 using namespace io::skizzay::identigen;
 
 namespace {
@@ -67,6 +76,139 @@ TEST_CASE("value_provider_utilities partitioned", "[value_provider]") {
    REQUIRE(provider.num_significant_bits() == 4);
 }
 
+namespace {
+   // Number of keys landing in each bucket, for keys 0, stride, 2 * stride, ..., plus the number out of range
+   std::vector<std::size_t> bucket_counts(value_provider auto const &provider, std::size_t const num_buckets,
+                                          std::uint64_t const stride, std::size_t const num_keys) {
+      std::vector<std::size_t> counts(num_buckets + 1);
+      auto const now = std::chrono::system_clock::now();
+      for (std::uint64_t i = 0; i < num_keys; ++i) {
+         ++counts[std::min(provider.value(now, i * stride), num_buckets)];
+      }
+      return counts;
+   }
+
+   // Whether every bucket is within 10% of an even share and no key is out of range
+   bool evenly_spread(std::vector<std::size_t> const &counts, std::size_t const num_keys) {
+      auto const buckets = std::span{counts}.first(counts.size() - 1);
+      auto const expected = static_cast<double>(num_keys) / static_cast<double>(buckets.size());
+      return 0 == counts.back() && std::ranges::all_of(buckets, [expected](auto const n) {
+         return std::abs(static_cast<double>(n) - expected) < 0.1 * expected;
+      });
+   }
+}
+
+TEST_CASE("value_provider_utilities partitioned is the remainder of the hash", "[value_provider]") {
+   std::mt19937_64 random{42};
+   auto const num_buckets = GENERATE(as<std::size_t>{}, 1, 2, 3, 7, 1000, 1ull << 32, (1ull << 63) + 1,
+                                     ~std::uint64_t{});
+   auto const provider = value_provider_utilities::partitioned(num_buckets);
+   auto const now = std::chrono::system_clock::now();
+   for (int i = 0; i < 10000; ++i) {
+      auto const x = random();
+      REQUIRE(provider.value(now, x) == x % num_buckets);
+   }
+   REQUIRE(provider.value(now, ~std::uint64_t{}) == ~std::uint64_t{} % num_buckets);
+}
+
+TEST_CASE("value_provider_utilities partitioned_uniform spreads strided keys", "[value_provider]") {
+   constexpr std::size_t num_keys = 100000;
+   auto const num_buckets = GENERATE(as<std::size_t>{}, 8, 10, 1000);
+   auto const provider = value_provider_utilities::partitioned_uniform(num_buckets);
+   REQUIRE(provider.num_significant_bits() ==
+           value_provider_utilities::calculate_num_significant_bits(num_buckets - 1));
+   for (std::uint64_t const stride: {1, 8, 1024}) {
+      auto const counts = bucket_counts(provider, num_buckets, stride, num_keys * num_buckets / 10);
+      REQUIRE(evenly_spread(counts, num_keys * num_buckets / 10));
+   }
+   // Where the remainder puts every key in one bucket
+   auto const remainders = bucket_counts(value_provider_utilities::partitioned(8), 8, 8, num_keys);
+   REQUIRE(remainders[0] == num_keys);
+}
+
+TEST_CASE("value_provider_utilities partitions a hashed_key as its bare key", "[value_provider]") {
+   auto const now = std::chrono::system_clock::now();
+   auto const provider = value_provider_utilities::partitioned(1000);
+   for (std::string const k: {"abc", "tenant-42", ""}) {
+      auto const expected = provider.value(now, k);
+      REQUIRE(provider.value(now, hashed_key{k}) == expected);
+      REQUIRE(provider.value(now, hashed_key{std::string_view{k}}) == expected);
+      REQUIRE(provider.value(now, hashed_key{k, standard_hash{}}) == expected);
+   }
+}
+
+TEST_CASE("value_provider_utilities partitions with key_hash", "[value_provider]") {
+   constexpr std::size_t num_keys = 100000;
+   auto const provider = value_provider_utilities::partitioned(8, key_hash{});
+   REQUIRE(provider.num_significant_bits() == 3);
+   REQUIRE(evenly_spread(bucket_counts(provider, 8, 8, num_keys), num_keys));
+
+   auto const now = std::chrono::system_clock::now();
+   auto const strings = value_provider_utilities::partitioned_uniform(8, key_hash{});
+   REQUIRE(strings.value(now, std::string{"tenant"}) == strings.value(now, std::string_view{"tenant"}));
+   REQUIRE(strings.value(now, std::string{"tenant"}) < 8);
+}
+
+TEST_CASE("value_provider_utilities partitioned_consistent", "[value_provider]") {
+   constexpr std::size_t num_keys = 100000;
+   auto const now = std::chrono::system_clock::now();
+
+   SECTION("spreads keys evenly") {
+      auto const num_buckets = GENERATE(as<std::size_t>{}, 1, 10, 100);
+      for (std::uint64_t const stride: {1, 8, 1024}) {
+         auto const counts = bucket_counts(value_provider_utilities::partitioned_consistent(num_buckets), num_buckets,
+                                           stride, num_keys);
+         REQUIRE(evenly_spread(counts, num_keys));
+      }
+   }
+
+   SECTION("adding a bucket only moves keys into it") {
+      auto const num_buckets = GENERATE(as<std::size_t>{}, 1, 10, 63);
+      auto const before = value_provider_utilities::partitioned_consistent(num_buckets, 64);
+      auto const after = value_provider_utilities::partitioned_consistent(num_buckets + 1, 64);
+      REQUIRE(before.num_significant_bits() == after.num_significant_bits());
+      std::size_t moved = 0;
+      for (std::uint64_t k = 0; k < num_keys; ++k) {
+         if (auto const bucket = after.value(now, k); bucket != before.value(now, k)) {
+            REQUIRE(bucket == num_buckets);
+            ++moved;
+         }
+      }
+      auto const expected = static_cast<double>(num_keys) / static_cast<double>(num_buckets + 1);
+      REQUIRE(std::abs(static_cast<double>(moved) - expected) < 0.1 * expected);
+   }
+
+   SECTION("removing the last bucket only moves its keys") {
+      auto const before = value_provider_utilities::partitioned_consistent(20);
+      auto const after = value_provider_utilities::partitioned_consistent(19);
+      for (std::uint64_t k = 0; k < num_keys; ++k) {
+         if (auto const bucket = before.value(now, k); bucket != 19) {
+            REQUIRE(after.value(now, k) == bucket);
+         }
+      }
+   }
+}
+
+TEST_CASE("value_provider_utilities range_partitioned", "[value_provider]") {
+   auto const provider = value_provider_utilities::range_partitioned(std::vector<std::int64_t>{-100, 0, 100, 200, 300});
+   REQUIRE(value_provider_for<decltype(provider), std::chrono::system_clock::time_point, std::int64_t>);
+   REQUIRE(provider.num_significant_bits() == 3);
+   auto const now = std::chrono::system_clock::now();
+   REQUIRE(provider.value(now, -101) == 0);
+   REQUIRE(provider.value(now, -100) == 1);
+   REQUIRE(provider.value(now, 99) == 2);
+   REQUIRE(provider.value(now, 250) == 4);
+   REQUIRE(provider.value(now, 1000) == 5);
+
+   // Adjacent keys land in the same or the next bucket
+   std::size_t previous = 0;
+   for (std::int64_t k = -200; k < 400; ++k) {
+      auto const bucket = provider.value(now, k);
+      REQUIRE((bucket == previous || bucket == previous + 1));
+      previous = bucket;
+   }
+}
+
 TEST_CASE("value_provider_utilities from_timestamp", "[value_provider]") {
    using namespace std::chrono;
    auto const today = sys_days{std::chrono::floor<days>(system_clock::now())};
@@ -77,3 +219,16 @@ TEST_CASE("value_provider_utilities from_timestamp", "[value_provider]") {
    REQUIRE(provider.value(ts, 1) == expected);
    REQUIRE(provider.num_significant_bits() == 27);
 }
+
+TEST_CASE("value_provider_utilities from_current_cpu", "[value_provider]") {
+   auto const provider = value_provider_utilities::from_current_cpu();
+   REQUIRE(value_provider_for<decltype(provider), std::chrono::system_clock::time_point, int>);
+   REQUIRE(provider.num_significant_bits() ==
+           value_provider_utilities::calculate_num_significant_bits(value_provider_utilities::num_cpus() - 1));
+   REQUIRE(provider.value(std::chrono::system_clock::now(), 1) < value_provider_utilities::num_cpus());
+}
+
+TEST_CASE("value_provider_utilities from_current_numa_node", "[value_provider]") {
+   auto const provider = value_provider_utilities::from_current_numa_node();
+   REQUIRE(provider.value(std::chrono::system_clock::now(), 1) < value_provider_utilities::num_numa_nodes());
+}
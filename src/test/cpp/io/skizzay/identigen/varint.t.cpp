@@ -0,0 +1,58 @@
+//
+// Created by andrew on 10/16/26.
+//
+
+#include <io/skizzay/identigen/varint.h>
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <vector>
+
+using namespace io::skizzay::identigen;
+
+TEST_CASE("varint_utilities zigzag encodes small magnitudes of either sign to small values", "[varint]") {
+   REQUIRE(varint_utilities::zigzag_encode(0) == 0);
+   REQUIRE(varint_utilities::zigzag_encode(-1) == 1);
+   REQUIRE(varint_utilities::zigzag_encode(1) == 2);
+   REQUIRE(varint_utilities::zigzag_encode(-2) == 3);
+   for (std::int64_t const x: {std::int64_t{0}, std::int64_t{-5}, std::int64_t{12345}, INT64_MIN, INT64_MAX}) {
+      REQUIRE(varint_utilities::zigzag_decode(varint_utilities::zigzag_encode(x)) == x);
+   }
+}
+
+TEST_CASE("varint_utilities sizes values by their significant bits", "[varint]") {
+   REQUIRE(varint_utilities::size(0) == 1);
+   REQUIRE(varint_utilities::size(127) == 1);
+   REQUIRE(varint_utilities::size(128) == 2);
+   REQUIRE(varint_utilities::size(~std::uint64_t{}) == 10);
+   REQUIRE(varint_utilities::max_size<std::uint16_t> == 3);
+   REQUIRE(varint_utilities::max_size<std::int64_t> == 10);
+}
+
+TEST_CASE("varint_utilities decodes every length, near the end of the input as well as away from it", "[varint]") {
+   std::vector<std::uint64_t> expected;
+   for (std::size_t bits = 0; bits <= 64; ++bits) {
+      expected.push_back(64 == bits ? ~std::uint64_t{} : (std::uint64_t{1} << bits) - 1);
+   }
+   std::vector<std::byte> encoded(10 * expected.size());
+   std::size_t size = 0;
+   for (auto const x: expected) {
+      size += varint_utilities::encode(x, encoded.data() + size);
+   }
+   std::vector<std::uint64_t> actual(expected.size());
+   auto const [values, bytes] = varint_utilities::decode_n(encoded.data(), size, std::span{actual});
+   REQUIRE(values == expected.size());
+   REQUIRE(bytes == size);
+   REQUIRE(actual == expected);
+}
+
+TEST_CASE("varint_utilities stops at a value that does not fit", "[varint]") {
+   std::array<std::byte, 20> encoded{};
+   auto size = varint_utilities::encode(1, encoded.data());
+   size += varint_utilities::encode(70000, encoded.data() + size);
+   std::array<std::uint16_t, 2> actual{};
+   auto const [values, bytes] = varint_utilities::decode_n(encoded.data(), encoded.size(), std::span<std::uint16_t>{actual});
+   REQUIRE(values == 1);
+   REQUIRE(bytes == 1);
+   REQUIRE(actual[0] == 1);
+}